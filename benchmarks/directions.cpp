@@ -0,0 +1,94 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+
+#include "../tests/boost_direction.hpp"
+#include "array_point.hpp"
+#include "directions.hpp"
+#include "distributions.hpp"
+#include "point.hpp"
+#include "rng.hpp"
+
+using namespace lerw;
+
+// sum up the lengths so that the steps are not optimized away
+template <class Direction>
+auto steps(Direction direction, std::size_t n) -> double {
+  auto rng = Philox4x32{0, 0};
+  auto sum = 0.0;
+  for (std::size_t i = 0; i < n; ++i) {
+    sum += norm<Norm::L1>(direction(100.0, rng));
+  }
+  return sum;
+}
+
+TEST_CASE("L2Direction", "[direction]") {
+  const std::size_t n = 1000;
+
+  BENCHMARK("boost 2D") { return steps(BoostL2Direction<Point2D>{}, n); };
+  BENCHMARK("array 2D") { return steps(L2Direction<Point2D>{}, n); };
+  BENCHMARK("boost 3D") { return steps(BoostL2Direction<Point3D>{}, n); };
+  BENCHMARK("array 3D") { return steps(L2Direction<Point3D>{}, n); };
+  BENCHMARK("boost 4D") { return steps(BoostL2Direction<ArrayPoint<4>>{}, n); };
+  BENCHMARK("array 4D") { return steps(L2Direction<ArrayPoint<4>>{}, n); };
+  BENCHMARK("boost 5D") { return steps(BoostL2Direction<ArrayPoint<5>>{}, n); };
+  BENCHMARK("array 5D") { return steps(L2Direction<ArrayPoint<5>>{}, n); };
+}
+
+template <class Direction>
+auto steps(Direction direction, int r, std::size_t n) -> double {
+  auto rng = Philox4x32{0, 0};
+  auto sum = 0.0;
+  for (std::size_t i = 0; i < n; ++i) {
+    sum += norm<Norm::L1>(direction(r, rng));
+  }
+  return sum;
+}
+
+TEST_CASE("LinfDirection", "[direction]") {
+  const std::size_t n = 1000;
+
+  BENCHMARK("2D, r=5") { return steps(LinfDirection<Point2D>{}, 5, n); };
+  BENCHMARK("2D, r=1000") { return steps(LinfDirection<Point2D>{}, 1000, n); };
+  BENCHMARK("3D, r=5") { return steps(LinfDirection<Point3D>{}, 5, n); };
+  BENCHMARK("3D, r=1000") { return steps(LinfDirection<Point3D>{}, 1000, n); };
+}
+
+TEST_CASE("L1Direction", "[direction]") {
+  const std::size_t n = 1000;
+
+  BENCHMARK("2D, r=5") { return steps(L1Direction<Point2D>{}, 5, n); };
+  BENCHMARK("2D, r=1000") { return steps(L1Direction<Point2D>{}, 1000, n); };
+  BENCHMARK("3D, r=5") { return steps(L1Direction<Point3D>{}, 5, n); };
+  BENCHMARK("3D, r=1000") { return steps(L1Direction<Point3D>{}, 1000, n); };
+  BENCHMARK("5D, r=5") { return steps(L1Direction<ArrayPoint<5>>{}, 5, n); };
+  BENCHMARK("5D, r=1000") {
+    return steps(L1Direction<ArrayPoint<5>>{}, 1000, n);
+  };
+}
+
+// lengths as in a walk, most of them small enough for the tables of
+// shells.hpp
+template <class Direction>
+auto zipf_steps(Direction direction, std::size_t n) -> double {
+  auto rng = Philox4x32{0, 0};
+  auto length = Zipf<int>{1.0};
+  auto sum = 0.0;
+  for (std::size_t i = 0; i < n; ++i) {
+    sum += norm<Norm::L1>(direction(length(rng), rng));
+  }
+  return sum;
+}
+
+TEST_CASE("Zipf lengths", "[direction]") {
+  const std::size_t n = 1000;
+
+  BENCHMARK("L1 2D") { return zipf_steps(L1Direction<Point2D>{}, n); };
+  BENCHMARK("L1 3D") { return zipf_steps(L1Direction<Point3D>{}, n); };
+  BENCHMARK("L1 5D") { return zipf_steps(L1Direction<ArrayPoint<5>>{}, n); };
+  BENCHMARK("LINF 2D") { return zipf_steps(LinfDirection<Point2D>{}, n); };
+  BENCHMARK("LINF 3D") { return zipf_steps(LinfDirection<Point3D>{}, n); };
+  BENCHMARK("LINF 5D") {
+    return zipf_steps(LinfDirection<ArrayPoint<5>>{}, n);
+  };
+}
@@ -0,0 +1,84 @@
+#include <boost/math/distributions/pareto.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "distributions.hpp"
+#include "rng.hpp"
+
+using namespace lerw;
+
+// the previous implementation, based on boost::math::quantile
+struct BoostPareto {
+  std::uniform_real_distribution<> uniform{};
+  boost::math::pareto_distribution<> pareto;
+
+  explicit BoostPareto(double alpha) : pareto{1.0, alpha} {}
+
+  template <std::uniform_random_bit_generator RNG>
+  auto operator()(RNG &rng) -> double {
+    return boost::math::quantile(pareto, uniform(rng));
+  }
+};
+
+// the previous implementation, Devroye's rejection sampler
+struct DevroyeZipf {
+  std::uniform_real_distribution<> uniform{};
+  double alpha;
+  double b = std::pow(2, alpha);
+
+  template <std::uniform_random_bit_generator RNG>
+  auto operator()(RNG &rng) -> std::int32_t {
+    while (true) {
+      const double u = uniform(rng);
+      const auto X = static_cast<std::int32_t>(std::pow(u, -1.0 / alpha));
+      const long double T = std::pow(1 + 1.0 / X, alpha);
+      const double v = uniform(rng);
+      if (v * X * (T - 1) / (b - 1) <= T / b) {
+        return X;
+      }
+    }
+  }
+};
+
+template <class Distribution>
+auto draws(Distribution distribution, std::size_t n) -> double {
+  auto rng = Philox4x32{0, 0};
+  auto sum = 0.0;
+  for (std::size_t i = 0; i < n; ++i) {
+    sum += static_cast<double>(distribution(rng));
+  }
+  return sum;
+}
+
+TEST_CASE("Pareto", "[distribution]") {
+  const std::size_t n = 1000;
+  const auto alpha = 1.5;
+
+  BENCHMARK("boost quantile") { return draws(BoostPareto{alpha}, n); };
+  BENCHMARK("closed form") { return draws(Pareto{alpha}, n); };
+  BENCHMARK("fill") {
+    auto rng = Philox4x32{0, 0};
+    auto xs = std::vector<double>(n);
+    Pareto{alpha}.fill(xs, rng);
+    return std::accumulate(xs.cbegin(), xs.cend(), 0.0);
+  };
+}
+
+TEST_CASE("Zipf", "[distribution]") {
+  const std::size_t n = 1000;
+  const auto alpha = 1.5;
+
+  BENCHMARK("devroye") { return draws(DevroyeZipf{.alpha = alpha}, n); };
+  BENCHMARK("rejection-inversion") { return draws(Zipf{alpha}, n); };
+  BENCHMARK("fill") {
+    auto rng = Philox4x32{0, 0};
+    auto xs = std::vector<std::int32_t>(n);
+    Zipf{alpha}.fill(xs, rng);
+    return std::accumulate(xs.cbegin(), xs.cend(), 0.0);
+  };
+}
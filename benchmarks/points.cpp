@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <array>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "array_point.hpp"
+#include "directions.hpp"
+#include "distributions.hpp"
+#include "generator.hpp"
+#include "ldstepper.hpp"
+#include "rng.hpp"
+#include "stopper.hpp"
+#include "visited.hpp"
+
+using namespace lerw;
+
+// the previous implementation of ArrayPoint, with scalar loops
+template <std::size_t Dim> struct ScalarArrayPoint {
+  std::array<int_t, Dim> values;
+
+  auto operator+=(const ScalarArrayPoint &rhs) -> ScalarArrayPoint & {
+    std::transform(values.cbegin(), values.cend(), rhs.values.cbegin(),
+                   values.begin(),
+                   [](int_t a, int_t b) { return saturating_add(a, b); });
+    return *this;
+  }
+
+  friend auto operator+(ScalarArrayPoint lhs,
+                        const ScalarArrayPoint &rhs) -> ScalarArrayPoint {
+    lhs += rhs;
+    return lhs;
+  }
+
+  auto operator==(const ScalarArrayPoint &) const -> bool = default;
+};
+
+template <Norm N, std::size_t Dim>
+auto norm(const ScalarArrayPoint<Dim> &p) -> double {
+  return std::apply(
+      [](const auto &...args) {
+        return norm<N, std::decay_t<decltype(args)>...>(args...);
+      },
+      p.values);
+}
+
+template <std::size_t Dim>
+auto coordinates(const ScalarArrayPoint<Dim> &p) -> std::array<int_t, Dim> {
+  return p.values;
+}
+
+template <std::size_t Dim> struct std::hash<ScalarArrayPoint<Dim>> {
+  auto operator()(const ScalarArrayPoint<Dim> &point) const -> std::size_t {
+    std::size_t seed = 0;
+    for (const auto &value : point.values) {
+      seed ^= std::hash<int_t>{}(value) + 0x9e3779b9 + (seed << 6) +
+              (seed >> 2);
+    }
+    return seed;
+  }
+};
+
+// the same steps as points of type P
+template <class P, std::size_t Dim>
+auto as(const std::vector<ArrayPoint<Dim>> &steps) -> std::vector<P> {
+  auto result = std::vector<P>{};
+  for (const auto &step : steps) {
+    const auto x = coordinates(step);
+    result.push_back(constructor<P>{}(x.cbegin(), x.cend()));
+  }
+  return result;
+}
+
+// a random walk: add the steps up, and hash and compare the positions by
+// putting them into a set
+template <class P> auto walk(const std::vector<P> &steps) -> std::size_t {
+  auto visited = hash_set<P>{};
+  auto position = zero<P>();
+  for (const auto &step : steps) {
+    position += step;
+    visited.insert(position);
+  }
+  return visited.size();
+}
+
+template <class P> auto lerw_lengths(std::size_t n) -> std::size_t {
+  auto generator = LoopErasedRandomWalkGenerator{
+      DistanceStopper<Norm::L1>{30},
+      LDStepper{Zipf<int_t>{1.0}, L1Direction<P>{}}};
+  auto workspace = Workspace<P, HashVisited<P>>{};
+  auto length = std::size_t{0};
+  for (std::size_t i = 0; i < n; ++i) {
+    auto rng = Philox4x32{0, i};
+    length += generator(rng, workspace).size();
+  }
+  return length;
+}
+
+template <std::size_t Dim> auto compare() -> void {
+  using Scalar = ScalarArrayPoint<Dim>;
+  using Vector = ArrayPoint<Dim>;
+  const auto name = std::to_string(Dim) + "D ";
+
+  auto rng = Philox4x32{0, 0};
+  auto direction = L1Direction<Vector>{};
+  auto steps = std::vector<Vector>{};
+  for (std::size_t i = 0; i < 10000; ++i) {
+    steps.push_back(direction(1 + static_cast<int>(i % 5), rng));
+  }
+  const auto scalar_steps = as<Scalar>(steps);
+
+  BENCHMARK(name + "walk scalar") { return walk(scalar_steps); };
+  BENCHMARK(name + "walk vector") { return walk(steps); };
+  BENCHMARK(name + "lerw scalar") { return lerw_lengths<Scalar>(100); };
+  BENCHMARK(name + "lerw vector") { return lerw_lengths<Vector>(100); };
+}
+
+// only 4 and 8 dimensions are vectorized, the others are the same
+TEST_CASE("Vectorized ArrayPoint", "[point]") {
+  compare<4>();
+  compare<5>();
+  compare<6>();
+  compare<7>();
+  compare<8>();
+}
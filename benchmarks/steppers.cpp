@@ -0,0 +1,98 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "array_point.hpp"
+#include "directions.hpp"
+#include "distributions.hpp"
+#include "generator.hpp"
+#include "jumpstepper.hpp"
+#include "ldstepper.hpp"
+#include "point.hpp"
+#include "rng.hpp"
+#include "stopper.hpp"
+
+using namespace lerw;
+
+// the end of a random walk of n steps (returned, so that the steps are not
+// optimized away)
+template <class Stepper> auto end_point(Stepper stepper, std::size_t n) {
+  auto rng = Philox4x32{0, 0};
+  auto p = zero<typename Stepper::Point>();
+  for (std::size_t i = 0; i < n; ++i) {
+    p = stepper(p, rng);
+  }
+  return p;
+}
+
+template <class Direction, Norm n>
+auto jump_stepper(double alpha, int radius) {
+  using Point = Direction::result_type;
+  const auto table = radius == 0
+                         ? nullptr
+                         : std::make_shared<const JumpTable<Point>>(
+                               JumpTable<Point>::template zipf<n>(alpha,
+                                                                  radius));
+  return JumpStepper{table, Zipf{alpha, radius + 1}, Direction{}};
+}
+
+template <class Direction, Norm n> auto compare(const std::string &name) {
+  const std::size_t steps = 1000;
+  const auto alpha = 1.0;
+
+  BENCHMARK(name + " LDStepper") {
+    return end_point(LDStepper{Zipf{alpha}, Direction{}}, steps);
+  };
+  for (const auto radius : {8, 64}) {
+    const auto stepper = jump_stepper<Direction, n>(alpha, radius);
+    BENCHMARK(name + " JumpStepper, radius " + std::to_string(radius)) {
+      return end_point(stepper, steps);
+    };
+  }
+}
+
+TEST_CASE("JumpStepper", "[stepper]") {
+  compare<L1Direction<Point2D>, Norm::L1>("L1 2D");
+  compare<LinfDirection<Point2D>, Norm::LINF>("LINF 2D");
+  compare<L1Direction<Point3D>, Norm::L1>("L1 3D");
+  compare<L1Direction<ArrayPoint<4>>, Norm::L1>("L1 4D");
+}
+
+// the total length of n loop-erased walks
+template <Norm n, class Stepper>
+auto lerw_lengths(Stepper stepper, double distance, bool skip_exits,
+                  std::size_t walks) -> std::size_t {
+  using generator_t =
+      LoopErasedRandomWalkGenerator<DistanceStopper<n>, Stepper>;
+  auto generator =
+      generator_t{DistanceStopper<n>{distance}, std::move(stepper), skip_exits};
+  auto workspace = typename generator_t::Workspace{};
+  auto length = std::size_t{0};
+  for (std::size_t i = 0; i < walks; ++i) {
+    auto rng = Philox4x32{0, i};
+    length += generator(rng, workspace).size();
+  }
+  return length;
+}
+
+// for small alpha, many walks end with a jump far out of the ball
+TEST_CASE("Skipped exits", "[stepper]") {
+  const auto walks = std::size_t{1000};
+  for (const auto alpha : {0.3, 1.0}) {
+    const auto name = "alpha " + std::to_string(alpha).substr(0, 3);
+    const auto l2 = LDStepper{Pareto{alpha}, L2Direction<Point3D>{}};
+    const auto l1 = LDStepper{Zipf{alpha}, L1Direction<Point2D>{}};
+    for (const auto skip : {false, true}) {
+      const auto mode = skip ? ", skip exits" : "";
+      BENCHMARK(name + " L2 3D" + mode) {
+        return lerw_lengths<Norm::L2>(l2, 30, skip, walks);
+      };
+      BENCHMARK(name + " L1 2D" + mode) {
+        return lerw_lengths<Norm::L1>(l1, 100, skip, walks);
+      };
+    }
+  }
+}
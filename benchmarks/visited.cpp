@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "directions.hpp"
+#include "distributions.hpp"
+#include "generator.hpp"
+#include "hash_set.hpp"
+#include "lattice_hash.hpp"
+#include "ldstepper.hpp"
+#include "point.hpp"
+#include "rng.hpp"
+#include "stepper.hpp"
+#include "stopper.hpp"
+#include "visited.hpp"
+
+using namespace lerw;
+
+// The points proposed to a loop-erased walk are the positions of the
+// underlying random walk: a loop-erased walk stops when its last point
+// leaves the ball, and that is the last point of the random walk as well.
+// So the traces are random walks, which the backends replay below.
+template <Norm N, class Length, class Direction>
+auto traces(double alpha, double distance, std::size_t n)
+    -> std::vector<std::vector<typename Direction::result_type>> {
+  auto generator =
+      RandomWalkGenerator{DistanceStopper<N>{distance},
+                          LDStepper{Length{alpha}, Direction{}}};
+  auto result = std::vector<std::vector<typename Direction::result_type>>{};
+  for (std::size_t i = 0; i < n; ++i) {
+    auto rng = Philox4x32{0, i};
+    result.push_back(generator(rng));
+  }
+  return result;
+}
+
+// erase the loops of all traces, reusing the workspace like a thread does
+template <class Point, class Visited>
+auto replay(const std::vector<std::vector<Point>> &walks,
+            Workspace<Point, Visited> &workspace) -> std::size_t {
+  // only the static reset and add are used, stopper and stepper don't matter
+  using generator_t =
+      LoopErasedRandomWalkGenerator<LengthStopper,
+                                    NearestNeighborStepper<Point>, Visited>;
+  auto length = std::size_t{0};
+  for (const auto &walk : walks) {
+    generator_t::reset(workspace);
+    for (std::size_t i = 1; i < walk.size(); ++i) {
+      generator_t::add(workspace.walk, workspace.visited, walk[i]);
+    }
+    length += workspace.walk.size();
+  }
+  return length;
+}
+
+template <Norm N, class Length, class Direction>
+auto compare_backends(std::string name, double alpha, double distance,
+                      std::size_t n) -> void {
+  using Point = Direction::result_type;
+  const auto walks = traces<N, Length, Direction>(alpha, distance, n);
+  const auto radius = static_cast<std::int64_t>(std::floor(distance));
+
+  auto hash = Workspace<Point, HashVisited<Point>>{};
+  auto lattice = Workspace<Point, LatticeVisited<Point>>{
+      .visited = LatticeVisited<Point>{radius}};
+  auto tiles = Workspace<Point, TileVisited<Point>>{};
+  auto gtl_set = Workspace<Point, SetVisited<hash_set<Point>>>{};
+  auto lifo_set = Workspace<Point, LifoHashSet<Point>>{};
+
+  BENCHMARK(name + " hash") { return replay(walks, hash); };
+  BENCHMARK(name + " lattice") { return replay(walks, lattice); };
+  BENCHMARK(name + " tiles") { return replay(walks, tiles); };
+  BENCHMARK(name + " gtl_set") { return replay(walks, gtl_set); };
+#ifdef LERW_HAS_BOOST_FLAT_SET
+  auto boost_set = Workspace<Point, SetVisited<boost_hash_set<Point>>>{};
+  BENCHMARK(name + " boost_set") { return replay(walks, boost_set); };
+#endif
+  BENCHMARK(name + " lifo_set") { return replay(walks, lifo_set); };
+}
+
+TEST_CASE("Visited backends", "[visited]") {
+  // walks of L2 use Pareto lengths, walks of LINF Zipf lengths, as in lerw.hpp
+  using Pareto2D = L2Direction<Point2D>;
+  using Pareto3D = L2Direction<Point3D>;
+  using Zipf2D = LinfDirection<Point2D>;
+  using Zipf3D = LinfDirection<Point3D>;
+
+  for (const auto alpha : {0.5, 1.8}) {
+    const auto a = " a=" + std::to_string(alpha).substr(0, 3);
+    compare_backends<Norm::L2, Pareto, Pareto2D>("2D L2 R=100" + a, alpha,
+                                                 100, 100);
+    compare_backends<Norm::L2, Pareto, Pareto2D>("2D L2 R=1000" + a, alpha,
+                                                 1000, 10);
+    compare_backends<Norm::LINF, Zipf<int_t>, Zipf2D>("2D LINF R=1000" + a,
+                                                      alpha, 1000, 10);
+    compare_backends<Norm::L2, Pareto, Pareto3D>("3D L2 R=30" + a, alpha, 30,
+                                                 100);
+    compare_backends<Norm::L2, Pareto, Pareto3D>("3D L2 R=100" + a, alpha,
+                                                 100, 10);
+    compare_backends<Norm::LINF, Zipf<int_t>, Zipf3D>("3D LINF R=100" + a,
+                                                      alpha, 100, 10);
+  }
+}
+
+template <class Hash, class Point>
+auto report(const std::string &name,
+            const std::vector<std::vector<Point>> &walks) -> void {
+  auto collisions = 0.0;
+  auto mean = 0.0;
+  auto longest = std::size_t{0};
+  for (const auto &walk : walks) {
+    const auto stats = hash_statistics<Hash>(walk);
+    collisions += stats.collision_rate;
+    mean += stats.mean_probe_length;
+    longest = std::max(longest, stats.max_probe_length);
+  }
+  const auto n = static_cast<double>(walks.size());
+  std::cout << name << ": collisions " << collisions / n << ", probes "
+            << mean / n << " (max " << longest << ")\n";
+}
+
+template <Norm N, class Length, class Direction>
+auto compare_hashes(std::string name, double alpha, double distance,
+                    std::size_t n) -> void {
+  using Point = Direction::result_type;
+  const auto walks = traces<N, Length, Direction>(alpha, distance, n);
+
+  report<std::hash<Point>>(name + " std", walks);
+  report<PackedHash>(name + " packed", walks);
+  report<MortonHash>(name + " morton", walks);
+
+  auto std_map = Workspace<Point, HashVisited<Point>>{};
+  auto packed_map = Workspace<Point, HashVisited<Point, PackedHash>>{};
+  auto morton_map = Workspace<Point, HashVisited<Point, MortonHash>>{};
+  auto std_lifo = Workspace<Point, LifoHashSet<Point>>{};
+  auto packed_lifo = Workspace<Point, LifoHashSet<Point, PackedHash>>{};
+  auto morton_lifo = Workspace<Point, LifoHashSet<Point, MortonHash>>{};
+
+  BENCHMARK(name + " hash std") { return replay(walks, std_map); };
+  BENCHMARK(name + " hash packed") { return replay(walks, packed_map); };
+  BENCHMARK(name + " hash morton") { return replay(walks, morton_map); };
+  BENCHMARK(name + " lifo_set std") { return replay(walks, std_lifo); };
+  BENCHMARK(name + " lifo_set packed") { return replay(walks, packed_lifo); };
+  BENCHMARK(name + " lifo_set morton") { return replay(walks, morton_lifo); };
+}
+
+TEST_CASE("Lattice hashes", "[hash]") {
+  using Pareto2D = L2Direction<Point2D>;
+  using Pareto3D = L2Direction<Point3D>;
+  using Zipf3D = LinfDirection<Point3D>;
+
+  for (const auto alpha : {0.5, 1.8}) {
+    const auto a = " a=" + std::to_string(alpha).substr(0, 3);
+    compare_hashes<Norm::L2, Pareto, Pareto2D>("2D L2 R=100" + a, alpha, 100,
+                                               100);
+    compare_hashes<Norm::L2, Pareto, Pareto2D>("2D L2 R=1000" + a, alpha,
+                                               1000, 10);
+    compare_hashes<Norm::L2, Pareto, Pareto3D>("3D L2 R=100" + a, alpha, 100,
+                                               10);
+    compare_hashes<Norm::LINF, Zipf<int_t>, Zipf3D>("3D LINF R=100" + a,
+                                                    alpha, 100, 10);
+  }
+}
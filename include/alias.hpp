@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace lerw {
+
+// Sample an index i with probability weights[i] / sum(weights) in O(1),
+// using Walker's alias method (with Vose's construction).
+struct AliasTable {
+  using result_type = std::size_t;
+
+  // probability of keeping the index drawn uniformly, alias otherwise
+  std::vector<double> probability;
+  std::vector<std::uint32_t> alias;
+
+  explicit AliasTable(std::span<const double> weights)
+      : probability(weights.size()), alias(weights.size()) {
+    const auto n = weights.size();
+    auto total = 0.0;
+    for (const auto w : weights) {
+      if (not(w >= 0.0)) {
+        throw std::invalid_argument{"Weights need to be non-negative."};
+      }
+      total += w;
+    }
+    if (n == 0 || not(total > 0.0)) {
+      throw std::invalid_argument{"Weights need to have a positive sum."};
+    }
+
+    auto small = std::vector<std::uint32_t>{};
+    auto large = std::vector<std::uint32_t>{};
+    for (std::uint32_t i = 0; i < n; ++i) {
+      probability[i] = weights[i] * static_cast<double>(n) / total;
+      alias[i] = i;
+      (probability[i] < 1.0 ? small : large).push_back(i);
+    }
+    while (not small.empty() && not large.empty()) {
+      const auto s = small.back();
+      const auto l = large.back();
+      small.pop_back();
+      alias[s] = l;
+      probability[l] -= 1.0 - probability[s];
+      if (probability[l] < 1.0) {
+        large.pop_back();
+        small.push_back(l);
+      }
+    }
+    // what is left is 1 up to rounding
+    for (const auto i : small) {
+      probability[i] = 1.0;
+    }
+    for (const auto i : large) {
+      probability[i] = 1.0;
+    }
+  }
+
+  auto size() const -> std::size_t { return probability.size(); }
+
+  template <std::uniform_random_bit_generator RNG>
+  auto operator()(RNG &rng) const -> std::size_t {
+    // one uniform draw: the integer part picks the column, the fractional
+    // part decides between the column and its alias
+    const auto u = std::uniform_real_distribution<>{
+        0.0, static_cast<double>(size())}(rng);
+    const auto i = static_cast<std::size_t>(u);
+    // u < size(), but guard against rounding anyway
+    if (i >= size()) [[unlikely]] {
+      return alias[size() - 1];
+    }
+    return u - static_cast<double>(i) < probability[i] ? i : alias[i];
+  }
+};
+
+} // namespace lerw
@@ -1,13 +1,15 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
-
+#include <bit>
 #include <concepts>
 #include <cstdint>
 #include <functional>
 #include <unordered_set> // IWYU pragma: keep // std::hash
 
 #include "concepts.hpp" // IWYU pragma: keep // zero<T>(), etc
+#include "simd.hpp"
 #include "utils.hpp"
 
 namespace lerw {
@@ -17,28 +19,43 @@ using int_t = int32_t;
 // TODO:
 // template <std::size_t Dim> using ArrayPoint = std::Array<int_t, Dim>;
 
-// For 2- and 3-dimension, this is as fast as struct{int x; int y; int z;}
-template <std::size_t Dim> struct ArrayPoint {
-  std::array<int_t, Dim> values;
-
-  constexpr auto operator+=(const ArrayPoint<Dim> &rhs) -> ArrayPoint<Dim> & {
+// For 2- and 3-dimension, this is as fast as struct{int x; int y; int z;}.
+// The coordinate type is a parameter, as for the points in point.hpp.
+// In 4 and 8 dimensions, the coordinates fill a vector register, and
+// adding and hashing work on all of them at once (see simd.hpp), as long as
+// they take 8 to 64 bytes (the most the hash takes). Padding the other
+// dimensions up to that was slower, as the points take more memory.
+template <std::size_t Dim, std::signed_integral T = int_t> struct ArrayPoint {
+  static constexpr auto vectorized = Dim >= 4 && std::has_single_bit(Dim) &&
+                                     sizeof(T) * Dim >= 8 &&
+                                     sizeof(T) * Dim <= 64;
+
+  std::array<T, Dim> values;
+
+  constexpr auto operator+=(const ArrayPoint &rhs) -> ArrayPoint & {
+    if constexpr (vectorized) {
+      if not consteval {
+        values = simd::saturating_add(values, rhs.values);
+        return *this;
+      }
+    }
     std::transform(values.cbegin(), values.cend(), rhs.values.cbegin(),
-                   values.begin(), std::plus{});
+                   values.begin(),
+                   [](T a, T b) { return saturating_add(a, b); });
     return *this;
   }
 
-  constexpr friend auto
-  operator+(ArrayPoint<Dim> lhs,
-            const ArrayPoint<Dim> &rhs) -> ArrayPoint<Dim> {
+  constexpr friend auto operator+(ArrayPoint lhs,
+                                  const ArrayPoint &rhs) -> ArrayPoint {
     lhs += rhs;
     return lhs;
   }
 
-  constexpr auto operator==(const ArrayPoint<Dim> &) const -> bool = default;
+  constexpr auto operator==(const ArrayPoint &) const -> bool = default;
 };
 
-template <Norm N, std::size_t Dim>
-constexpr auto norm(const ArrayPoint<Dim> &p) -> double {
+template <Norm N, std::size_t Dim, class T>
+constexpr auto norm(const ArrayPoint<Dim, T> &p) -> double {
   return std::apply(
       [](const auto &...args) {
         return norm<N, std::decay_t<decltype(args)>...>(args...);
@@ -46,12 +63,16 @@ constexpr auto norm(const ArrayPoint<Dim> &p) -> double {
       p.values);
 }
 
+template <std::size_t Dim, class T>
+constexpr auto coordinates(const ArrayPoint<Dim, T> &p) -> std::array<T, Dim> {
+  return p.values;
+}
+
 template <class T>
 concept array_point = requires(T t) {
   t.values;
   // an array has a value_type and a tuple_size
-  requires std::same_as<typename decltype(t.values)::value_type,
-                        int_t>; // TODO: this is outdated
+  requires std::signed_integral<typename decltype(t.values)::value_type>;
   std::tuple_size_v<decltype(t.values)>;
 };
 
@@ -62,7 +83,7 @@ template <array_point T> constexpr auto dim() -> std::size_t {
 }
 
 template <array_point T> struct field<T> {
-  using type = int_t;
+  using type = decltype(T::values)::value_type;
 };
 
 template <array_point T> struct constructor<T> {
@@ -82,17 +103,21 @@ template <array_point T> struct constructor<T> {
 
 namespace std {
 
-template <std::size_t Dim> struct hash<lerw::ArrayPoint<Dim>> {
-  std::size_t operator()(const lerw::ArrayPoint<Dim> &point) const {
-    std::size_t seed = 0;
+template <std::size_t Dim, class T> struct hash<lerw::ArrayPoint<Dim, T>> {
+  std::size_t operator()(const lerw::ArrayPoint<Dim, T> &point) const {
+    if constexpr (lerw::ArrayPoint<Dim, T>::vectorized) {
+      return lerw::simd::hash(point.values);
+    } else {
+      std::size_t seed = 0;
 
-    for (const auto &value : point.values) {
-      // Boost's hash_combine formula
-      seed ^= std::hash<lerw::int_t>{}(value) + 0x9e3779b9 + (seed << 6) +
-              (seed >> 2);
-    }
+      for (const auto &value : point.values) {
+        // Boost's hash_combine formula
+        seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6) +
+                (seed >> 2);
+      }
 
-    return seed;
+      return seed;
+    }
   }
 };
 
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "utils.hpp"
+
+namespace lerw {
+
+// Decides whether a lattice point lies outside the ball of radius distance,
+// in exact integer arithmetic: no sqrt for L2, and no rounding or overflow.
+// Since the norm (L1, LINF) or squared norm (L2) of a lattice point is an
+// integer, comparing it with the distance reduces to comparing it with the
+// smallest integer that is outside.
+template <Norm N> struct Ball {
+  // 128 bits hold the square of a double's 52 fractional bits, and that of
+  // any 64 bit coordinate
+  __extension__ using uint128 = unsigned __int128;
+
+  // the smallest norm (L1, LINF) or squared norm (L2) outside the ball
+  uint128 exact;
+  // the same, clamped to 64 bits, which is all the norms of most points need
+  std::uint64_t threshold;
+
+  constexpr explicit Ball(double distance)
+      : exact{outside_from(distance)},
+        threshold{static_cast<std::uint64_t>(std::min(exact, uint128{max}))} {
+  }
+
+  template <class Point> constexpr auto outside(const Point &p) const -> bool {
+    auto r = std::uint64_t{0};
+    for (const auto x : coordinates(p)) {
+      const auto m = magnitude(static_cast<std::int64_t>(x));
+      if constexpr (N == Norm::LINF) {
+        r = std::max(r, m);
+      } else if (accumulate(r, m)) [[unlikely]] {
+        // Then it is beyond any 64 bit threshold, but not necessarily beyond
+        // a clamped one (distances from 2^32 on in L2, 2^64 in L1).
+        return threshold < max || outside_wide(p);
+      }
+    }
+    // a norm of 2^64 - 1 is only outside a clamped threshold if it is exact
+    return r >= threshold && (threshold < max || r >= exact);
+  }
+
+private:
+  static constexpr auto max = std::numeric_limits<std::uint64_t>::max();
+  static constexpr auto max128 = std::numeric_limits<uint128>::max();
+
+  // outside in 128 bits, saturating (only the sums of 8 squares of 64 bit
+  // coordinates can reach that)
+  template <class Point>
+  constexpr auto outside_wide(const Point &p) const -> bool {
+    auto r = uint128{0};
+    for (const auto x : coordinates(p)) {
+      const auto m = uint128{magnitude(static_cast<std::int64_t>(x))};
+      const auto term = N == Norm::L1 ? m : m * m;
+      r = r > max128 - term ? max128 : r + term;
+    }
+    return r >= exact;
+  }
+
+  // in unsigned arithmetic, where -x does not overflow
+  static constexpr auto magnitude(std::int64_t x) -> std::uint64_t {
+    const auto u = static_cast<std::uint64_t>(x);
+    return x < 0 ? 0 - u : u;
+  }
+
+  // adds m (L1) or m^2 (L2) to r, true if that overflows. Only the sums of
+  // squares overflow for int32 coordinates, anything may for int64 ones.
+  static constexpr auto accumulate(std::uint64_t &r, std::uint64_t m)
+      -> bool {
+    if constexpr (N == Norm::L1) {
+      return __builtin_add_overflow(r, m, &r);
+    } else {
+      auto square = std::uint64_t{0};
+      return __builtin_mul_overflow(m, m, &square) ||
+             __builtin_add_overflow(r, square, &r);
+    }
+  }
+
+  static constexpr auto outside_from(double distance) -> uint128 {
+    // everything is outside a ball of negative (or NaN) radius
+    if (not(distance >= 0)) {
+      return 0;
+    }
+    // beyond these, no norm (or squared norm) fits into 128 bits
+    if (distance >= (N == Norm::L2 ? 0x1p64 : 0x1p127)) {
+      return max128;
+    }
+    if constexpr (N != Norm::L2) {
+      return static_cast<uint128>(std::floor(distance)) + 1;
+    } else {
+      const auto k = static_cast<std::uint64_t>(std::floor(distance));
+      // distance^2 would round in double, but distance = k + g / 2^52
+      // exactly (for distance >= 1, otherwise k = 0 and the square is 0
+      // anyway), so floor(distance^2) = k^2 + floor((2kg + g^2/2^52)/2^52)
+      const auto g = static_cast<std::uint64_t>(
+          (distance - std::floor(distance)) * 0x1p52);
+      const auto cross = 2 * uint128{k} * g + (uint128{g} * g >> 52);
+      const auto square = uint128{k} * k + (cross >> 52);
+      return square + 1;
+    }
+  }
+};
+
+} // namespace lerw
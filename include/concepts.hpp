@@ -92,4 +92,12 @@ concept stopper = requires(S s) {
   { s(std::vector<int>{}) } -> std::same_as<bool>;
 };
 
+// A stopper that is told the points of a walk one at a time, starting with
+// the origin, so that the walk does not need to be stored. on_step returns
+// whether the walk stops at p, and agrees with s(walk) for the walk up to p.
+template <class S, class P>
+concept incremental_stopper = requires(S s, const P &p) {
+  { s.on_step(p) } -> std::same_as<bool>;
+};
+
 } // namespace lerw
@@ -2,33 +2,101 @@
 
 #include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <numeric>
 #include <random>
+#include <type_traits>
+#include <vector>
 
 #include <boost/math/special_functions.hpp>
-#include <boost/random/uniform_on_sphere.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/uniform_01.hpp>
 
+#include "alias.hpp"
 #include "concepts.hpp"
+#include "shells.hpp"
 
 namespace lerw {
 
 // uniformly pick direction from sphere, round to nearest integer lattice point
 template <point Point> struct L2Direction {
+  // The direction is sampled like boost::random::uniform_on_sphere does it
+  // (so the results are identical), but into a std::array instead of a
+  // std::vector to avoid allocations on every step.
+
   using result_type = Point;
 
-  boost::random::uniform_on_sphere<> direction{static_cast<int>(dim<Point>())};
+  using int_t = field<Point>::type;
+
+  static constexpr std::size_t d = dim<Point>();
+  static constexpr auto lowest =
+      static_cast<double>(std::numeric_limits<int_t>::min());
+  // the largest double that converts to int_t: the maximum of int64_t is
+  // not a double, so its low bits are cleared
+  static constexpr auto excess =
+      std::max(0, std::numeric_limits<int_t>::digits -
+                      std::numeric_limits<double>::digits);
+  static constexpr auto highest = static_cast<double>(
+      std::numeric_limits<int_t>::max() >> excess << excess);
 
   template <std::uniform_random_bit_generator RNG>
   constexpr auto operator()(double r, RNG &rng) -> Point {
-    auto dir = direction(rng);
-    std::transform(dir.begin(), dir.end(), dir.begin(),
-                   [r](auto x) { return r * x; });
-    auto dir_int = std::vector<typename field<Point>::type>{};
-    std::transform(dir.begin(), dir.end(), std::back_inserter(dir_int),
-                   [](auto x) { return std::round(x); });
-    return constructor<Point>{}(dir_int.cbegin(), dir_int.cend());
+    const auto dir = unit_vector(rng);
+    auto coordinates = std::array<int_t, d>{};
+    // clamped, since a long jump need not fit into int_t
+    std::transform(dir.cbegin(), dir.cend(), coordinates.begin(), [r](auto x) {
+      return static_cast<int_t>(
+          std::clamp(std::round(r * x), lowest, highest));
+    });
+    return constructor<Point>{}(coordinates.cbegin(), coordinates.cend());
+  }
+
+  template <std::uniform_random_bit_generator RNG>
+  static constexpr auto unit_vector(RNG &rng) -> std::array<double, d> {
+    auto uniform = boost::random::uniform_01<double>{};
+    if constexpr (d == 1) {
+      return {uniform(rng) < 0.5 ? -1.0 : 1.0};
+    } else if constexpr (d == 2) {
+      // rejection from the unit disk
+      double x, y, sqsum;
+      do {
+        x = uniform(rng) * 2 - 1;
+        y = uniform(rng) * 2 - 1;
+        sqsum = x * x + y * y;
+      } while (sqsum == 0 || sqsum > 1);
+      const auto mult = 1 / std::sqrt(sqsum);
+      return {x * mult, y * mult};
+    } else if constexpr (d == 3) {
+      // Marsaglia (1972)
+      double x, y, sqsum;
+      do {
+        x = uniform(rng) * 2 - 1;
+        y = uniform(rng) * 2 - 1;
+        sqsum = x * x + y * y;
+      } while (sqsum > 1);
+      const auto mult = 2 * std::sqrt(1 - sqsum);
+      return {x * mult, y * mult, 2 * sqsum - 1};
+    } else {
+      // normalized vector of standard normals (boost uses a ziggurat)
+      auto normal = boost::random::normal_distribution<double>{};
+      auto dir = std::array<double, d>{};
+      double sqsum;
+      do {
+        sqsum = 0;
+        for (auto &x : dir) {
+          x = normal(rng);
+          sqsum += x * x;
+        }
+      } while (sqsum == 0);
+      const auto inverse_distance = 1 / std::sqrt(sqsum);
+      for (auto &x : dir) {
+        x *= inverse_distance;
+      }
+      return dir;
+    }
   }
 };
 
@@ -41,83 +109,115 @@ constexpr auto random_sign(RNG &rng) -> std::int8_t {
 
 // uniformly pick direction from surface of L1-ball
 template <point Point> struct L1Direction {
-  // find an integer solution to
-  // sum |x_i| = r
-  // by using the 'stars and bars' method.
-  // Example:
-  // For r=5, d=3
-  // |****|*
-  // corresponds to (0, 4, 1)
-  // After this, the sign of each coordinate is randomized.
-  // Because (-1 * 0 = 1 * 0 = 0), this oversamples points
-  // by a factor of 2 for every 0-coordinate. To combat
-  // this, reject a point with a probability of 0.5 for
-  // every 0-coordinate.
-  // TODO: The stars-and-bars could be adapted to get around this multi-counting
+  // Sample a point on the radius r L1-ball by
+  // - choosing the number j of nonzero coordinates. The options are weighed
+  //   by the number of points with exactly j nonzero coordinates,
+  //   C(d, j) * 2^j * C(r - 1, j - 1).
+  // - splitting r into j positive parts using 'stars and bars': the j - 1
+  //   bars are a uniform subset of {1, ..., r - 1}.
+  //   Example:
+  //   For r=5, j=2
+  //   ****|*
+  //   corresponds to (4, 1)
+  // - randomizing the sign of every part, and choosing a uniform subset of
+  //   j coordinates to hold the parts.
+  // No step rejects, and the cost does not depend on r. Small r are picked
+  // from the points of the sphere instead, see shells.hpp.
 
   using result_type = Point;
 
   using int_t = field<Point>::type;
+  using float_t = double;
 
   static constexpr std::size_t d = dim<Point>();
   static_assert(d > 0, "Out-of-bounds stuff happens when d = 0.");
+  static_assert(d <= 64, "Not enough sign bits.");
+
+  using sign_bits_t =
+      std::conditional_t<(d <= 32), std::uint32_t, std::uint64_t>;
+
+  using shells = Shells<d, Norm::L1>;
 
   template <std::uniform_random_bit_generator RNG>
   constexpr auto operator()(int_t r, RNG &rng) -> Point {
-    auto proposed = get_integer_solution(r, rng);
-    while (reject_for_zeros(proposed.cbegin(), proposed.cend(), rng)) {
-      proposed = get_integer_solution(r, rng);
+    if (r <= shells::radius) {
+      return shells::template sample<Point>(static_cast<std::size_t>(r), rng);
+    }
+
+    const auto j = choose_nonzero(r, rng);
+
+    // the unused bars are r, so the parts are followed by zeros
+    auto parts = sample_subset(r - 1, j - 1, rng);
+    std::sort(parts.begin(), parts.end());
+    std::adjacent_difference(parts.cbegin(), parts.cend(), parts.begin());
+    // all signs from a single draw
+    auto signs = std::uniform_int_distribution<sign_bits_t>{}(rng);
+    for (auto &c : parts) {
+      c = (signs & 1) ? -c : c;
+      signs >>= 1;
+    }
+
+    if (j == d) {
+      return constructor<Point>{}(parts.cbegin(), parts.cend());
     }
-    std::transform(proposed.cbegin(), proposed.cend(), proposed.begin(),
-                   [&rng](auto i) { return random_sign(rng) * i; });
-    return constructor<Point>{}(proposed.cbegin(), proposed.cend());
+
+    // the order of the parts is already uniform, so they can be assigned to
+    // the positions in increasing order
+    auto positions = sample_subset(static_cast<int_t>(d), j, rng);
+    std::sort(positions.begin(), positions.end());
+    auto coordinates = std::array<int_t, d>{};
+    for (std::size_t i = 0; i < j; ++i) {
+      coordinates[static_cast<std::size_t>(positions[i] - 1)] = parts[i];
+    }
+    return constructor<Point>{}(coordinates.cbegin(), coordinates.cend());
   }
 
   template <std::uniform_random_bit_generator RNG>
-  constexpr static auto get_integer_solution(int_t r,
-                                      RNG &rng) -> std::array<int_t, d> {
-    auto bars = sample_iota(r, rng);
-    bars[d - 1] = r + d;
-    std::sort(bars.begin(), bars.end());
-    auto stars = std::array<int_t, d>{};
-    std::adjacent_difference(bars.cbegin(), bars.cend(), stars.begin());
-    std::transform(stars.cbegin(), stars.cend(), stars.begin(),
-                   [&rng](auto s) { return (s - 1); });
-    return stars;
+  static auto choose_nonzero(int_t r, RNG &rng) -> std::size_t {
+    const auto weights = nonzero_weights(r);
+    const auto total = std::accumulate(weights.cbegin(), weights.cend(), 0.0);
+    // for large r, most points have no zero coordinate, so start at j = d
+    auto u = std::uniform_real_distribution<float_t>{0, total}(rng);
+    std::size_t j = d;
+    for (; j > 1 && u >= weights[j - 1]; --j) {
+      u -= weights[j - 1];
+    }
+    return j;
   }
 
-  template <class InputIt, std::uniform_random_bit_generator RNG>
-  constexpr static auto reject_for_zeros(InputIt first, InputIt last,
-                                  RNG &rng) -> bool {
-    auto d = std::uniform_int_distribution<std::int8_t>{0, 1};
-    return std::transform_reduce(
-        first, last, false, std::logical_or{},
-        [&d, &rng](auto c) { return c == 0 && d(rng) == 0; });
+  // weights[j - 1] is proportional to the number of points with exactly j
+  // nonzero coordinates, relative to j = 1
+  static constexpr auto nonzero_weights(int_t r) -> std::array<float_t, d> {
+    // w_{j+1} / w_j = 2 * (d - j) * (r - j) / ((j + 1) * j), which is 0 once
+    // there are more nonzero coordinates than r
+    auto weights = std::array<float_t, d>{};
+    weights[0] = 1;
+    for (std::size_t j = 1; j < d; ++j) {
+      const auto j_ = static_cast<float_t>(j);
+      weights[j] = weights[j - 1] * 2 * static_cast<float_t>(d - j) *
+                   std::max(static_cast<float_t>(r) - j_, 0.0) /
+                   ((j_ + 1) * j_);
+    }
+    return weights;
   }
 
+  // k <= d distinct values from {1, ..., n} (unsorted) using Floyd's
+  // algorithm, which draws exactly k numbers. The remaining entries are n + 1.
   template <std::uniform_random_bit_generator RNG>
-  constexpr static auto sample_iota(int_t r, RNG &rng) -> std::array<std::size_t, d> {
-    // equivalent to
-    // auto indices = std::vector<std::size_t>(r + d - 1);
-    // std::iota(indices.begin(), indices.end(), 1);
-    // auto result = std::array<std::size_t, d>{};
-    // std::sample(indices.cbegin(), indices.cend(), result.begin(), d - 1,
-    // rng);
-    // return result;
-    // but does this without materializing the indices-vector.
-    // This works fine for smallish d.
-    // See  Algorithm 3.4.2S of Seminumeric Algorithms (Knuth) for a less
-    // quadratic solution
-    auto dist = std::uniform_int_distribution<std::size_t>{1, r + d - 1};
-    auto result = std::array<std::size_t, d>{};
-    for (auto it = result.begin(); it + 1 < result.end(); ++it) {
-      auto next = dist(rng);
-      while (std::find(result.begin(), it, next) != it) {
-        next = dist(rng);
-      }
-      *it = next;
+  static constexpr auto sample_subset(int_t n, std::size_t k,
+                                      RNG &rng) -> std::array<int_t, d> {
+    auto subset = std::array<int_t, d>{};
+    subset.fill(static_cast<int_t>(n + 1));
+    const auto first = subset.begin();
+    auto last = subset.begin();
+    // (the casts undo the promotion of 16 bit coordinates to int)
+    for (auto i = static_cast<int_t>(n - static_cast<int_t>(k) + 1); i <= n;
+         ++i) {
+      const auto t = std::uniform_int_distribution<int_t>{1, i}(rng);
+      *last = std::find(first, last, t) == last ? t : i;
+      ++last;
     }
-    return result;
+    return subset;
   }
 };
 
@@ -133,6 +233,7 @@ template <point Point> struct LinfDirection {
   // - Then, choose k coordinates and assign them either +r or -r.
   // - Then, assign a number from [-r+1, ..., r-1] to each of the remaining
   //   coordinates.
+  // Small r are picked from the points of the sphere instead, see shells.hpp.
 
   using result_type = Point;
 
@@ -141,37 +242,85 @@ template <point Point> struct LinfDirection {
 
   static constexpr std::size_t d = dim<Point>();
 
+  using shells = Shells<d, Norm::LINF>;
+
   template <std::uniform_random_bit_generator RNG>
   constexpr auto operator()(int_t r, RNG &rng) -> Point {
+    if (r <= shells::radius) {
+      return shells::template sample<Point>(static_cast<std::size_t>(r), rng);
+    }
+
     const auto k = choose_k(r, rng);
 
     auto coordinates = std::array<int_t, d>{};
     auto last = std::transform(
         coordinates.cbegin(), coordinates.cbegin() + k, coordinates.begin(),
         [r, &rng](auto) { return r * random_sign(rng); });
-    constexpr int_t one{1}; // stupid typecasting
-    auto dist = std::uniform_int_distribution<int_t>{one - r, r - one};
+    // (the casts undo the promotion of 16 bit coordinates to int)
+    auto dist = std::uniform_int_distribution<int_t>{
+        static_cast<int_t>(1 - r), static_cast<int_t>(r - 1)};
     std::transform(last, coordinates.end(), last,
                    [&dist, &rng](auto) { return dist(rng); });
     std::shuffle(coordinates.begin(), coordinates.end(), rng);
     return constructor<Point>{}(coordinates.cbegin(), coordinates.cend());
   }
 
+  // for r < tabulated_radii, k is drawn from a precomputed alias table
+  static constexpr int_t tabulated_radii = 64;
+
   template <std::uniform_random_bit_generator RNG>
-  constexpr static auto choose_k(int_t r, RNG &rng) -> std::uint16_t {
-    const auto ak_sums = A_k_sums(r);
-    const auto i =
-        std::uniform_real_distribution<float_t>{0, ak_sums[d - 1]}(rng);
-    return static_cast<std::uint16_t>(
-        std::distance(ak_sums.cbegin(),
-                      std::lower_bound(ak_sums.cbegin(), ak_sums.cend(), i)));
+  static auto choose_k(int_t r, RNG &rng) -> std::uint16_t {
+    if (r < tabulated_radii) {
+      return static_cast<std::uint16_t>(
+          1 + k_tables()[static_cast<std::size_t>(r)](rng));
+    }
+
+    // For large r, the faces (k = 1) dominate. Weigh relative to A_1 using
+    // A_{k+1} / A_k = (d - k) / (k + 1) * 2 / (2r - 1), which avoids the
+    // binomial coefficients and powers, and invert starting at k = 1.
+    auto weights = std::array<float_t, d>{};
+    weights[0] = 1;
+    for (std::size_t k = 1; k < d; ++k) {
+      weights[k] = weights[k - 1] * static_cast<float_t>(d - k) /
+                   static_cast<float_t>(k + 1) * 2 /
+                   (2 * static_cast<float_t>(r) - 1);
+    }
+    const auto total = std::accumulate(weights.cbegin(), weights.cend(), 0.0);
+    auto u = std::uniform_real_distribution<float_t>{0, total}(rng);
+    std::uint16_t k = 1;
+    for (; k < d && u >= weights[k - 1]; ++k) {
+      u -= weights[k - 1];
+    }
+    return k;
   }
 
+  // alias tables for choosing k, indexed by r. Shared by all instances
+  // (directions are created per walk, so a per-object cache would be rebuilt
+  // all the time)
+  static auto k_tables() -> const std::vector<AliasTable> & {
+    static const auto tables = [] {
+      auto t = std::vector<AliasTable>{};
+      t.reserve(tabulated_radii);
+      // r = 0 is not a valid radius, only there to index by r
+      t.emplace_back(std::array{1.0});
+      for (int_t r = 1; r < tabulated_radii; ++r) {
+        auto weights = std::array<float_t, d>{};
+        for (std::size_t k = 1; k <= d; ++k) {
+          weights[k - 1] = A_k(static_cast<std::uint16_t>(k), r);
+        }
+        t.emplace_back(weights);
+      }
+      return t;
+    }();
+    return tables;
+  }
+
+  // cumulative number of points with 1, ..., d coordinates equal to +-r
   constexpr static auto A_k_sums(int_t r) -> std::array<float_t, d> {
     auto ak_sums = std::array<float_t, d>{};
     std::iota(ak_sums.begin(), ak_sums.end(), 1);
-    std::transform_exclusive_scan(ak_sums.cbegin(), ak_sums.cend(),
-                                  ak_sums.begin(), 0, std::plus{}, [r](auto k) {
+    std::transform_inclusive_scan(ak_sums.cbegin(), ak_sums.cend(),
+                                  ak_sums.begin(), std::plus{}, [r](auto k) {
                                     // this cast is fine because k <= d << 65535
                                     const auto k_ =
                                         static_cast<std::uint16_t>(k);
@@ -180,14 +329,14 @@ template <point Point> struct LinfDirection {
     return ak_sums;
   }
 
+  // number of points with exactly k coordinates equal to +-r
   constexpr static auto A_k(std::uint16_t k, int_t r) -> float_t {
     // boost forces floating point value return type, keep it throughout since
     // for large r the number of points on faces dominate all others
     const auto combinations = boost::math::binomial_coefficient<float_t>(d, k);
-    return combinations * std::pow(2, k) * std::pow(2 * r - 1, d - k);
+    return combinations * std::pow(2, k) *
+           std::pow(2 * static_cast<float_t>(r) - 1, d - k);
   }
-
-
 };
 
 } // namespace lerw
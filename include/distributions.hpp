@@ -1,64 +1,209 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
 #include <cmath>
 #include <concepts>
 #include <cstdint>
+#include <limits>
 #include <random>
-
-#include <boost/math/distributions/pareto.hpp>
+#include <span>
 #include <stdexcept>
 
 namespace lerw {
 
-// generate Pareto-distributed doubles
+// Branch-free log and exp for the batched samplers, so that loops over
+// them vectorize (unlike calls to std::log / std::exp). Relative error is
+// below 1e-15 for normal, positive x, respectively the argument of vexp
+// being below log(DBL_MAX) (larger arguments give inf).
+
+// adding 1.5 * 2^52 rounds to an integer, which then sits in the low bits
+inline constexpr auto magic = 0x1.8p52;
+inline constexpr auto magic_bits = std::bit_cast<std::uint64_t>(magic);
+
+constexpr auto vlog(double x) -> double {
+  constexpr auto sqrt2 = 1.4142135623730951;
+  constexpr auto ln2_hi = 6.93147180369123816490e-01;
+  constexpr auto ln2_lo = 1.90821492927058770002e-10;
+  const auto bits = std::bit_cast<std::uint64_t>(x);
+  // x = m * 2^e with m in [sqrt(2) / 2, sqrt(2)), the exponent is converted
+  // to double through the bits of `magic` (since int64 -> double does not
+  // vectorize without AVX-512)
+  auto e = std::bit_cast<double>(magic_bits + (bits >> 52)) - magic - 1023;
+  auto m = std::bit_cast<double>((bits & 0x000FFFFFFFFFFFFF) |
+                                 0x3FF0000000000000);
+  const auto big = m > sqrt2;
+  m = big ? 0.5 * m : m;
+  e = big ? e + 1 : e;
+  // log(m) = 2 atanh(s) = 2 (s + s^3 / 3 + s^5 / 5 + ...), |s| < 0.172
+  const auto s = (m - 1) / (m + 1);
+  const auto s2 = s * s;
+  auto series = 1.0 / 21;
+  for (auto k = 19; k > 0; k -= 2) {
+    series = series * s2 + 1.0 / k;
+  }
+  return e * ln2_hi + (e * ln2_lo + 2 * s * series);
+}
+
+constexpr auto vexp(double x) -> double {
+  constexpr auto log2e = 1.4426950408889634;
+  constexpr auto ln2_hi = 6.93147180369123816490e-01;
+  constexpr auto ln2_lo = 1.90821492927058770002e-10;
+  constexpr auto max_x = 709.782712893384; // log(DBL_MAX)
+  constexpr auto min_x = -708.3964185322641; // log(DBL_MIN)
+  const auto clamped = std::min(std::max(x, min_x), max_x);
+  // x = n log(2) + f with |f| <= log(2) / 2, rounding via `magic`
+  const auto shifted = clamped * log2e + magic;
+  const auto n = shifted - magic;
+  const auto f = (clamped - n * ln2_hi) - n * ln2_lo;
+  // Taylor series up to f^13 / 13!
+  auto series = 1.0;
+  for (auto k = 13; k > 0; --k) {
+    series = 1.0 + series * f / k;
+  }
+  // scale by 2^(n - 1) * 2 so that n = 1024 does not overflow the exponent
+  const auto scale = std::bit_cast<double>(
+      (std::bit_cast<std::uint64_t>(shifted) - magic_bits + 1022) << 52);
+  const auto result = series * scale * 2.0;
+  return x > max_x ? std::numeric_limits<double>::infinity() : result;
+}
+
+// generate Pareto-distributed doubles (with scale 1)
 struct Pareto {
   using result_type = double;
 
   std::uniform_real_distribution<> uniform{};
-  boost::math::pareto_distribution<> pareto;
+  // -1 / α
+  double exponent;
 
-  explicit Pareto(double alpha) : pareto{1.0, alpha} {};
+  explicit Pareto(double alpha) : exponent{-1.0 / alpha} {
+    if (alpha <= 0.0) {
+      throw std::invalid_argument{"Alpha needs to be larger than 0."};
+    }
+  };
 
   template <std::uniform_random_bit_generator RNG>
   auto operator()(RNG &rng) -> double {
-    // boost does ~ U^{-1/α}
-    return boost::math::quantile(pareto, uniform(rng));
+    // the quantile function, (1 - U)^{-1/α}
+    return std::pow(1.0 - uniform(rng), exponent);
+  }
+
+  // fill a block of step lengths at once
+  template <std::uniform_random_bit_generator RNG>
+  auto fill(std::span<double> out, RNG &rng) -> void {
+    std::generate(out.begin(), out.end(),
+                  [this, &rng] { return uniform(rng); });
+    quantiles(out);
+  }
+
+  // replace uniforms u in [0, 1) by (1 - u)^{-1/α}
+  auto quantiles(std::span<double> us) const -> void {
+    // a local copy, otherwise exponent may alias us and is reloaded
+    const auto e = exponent;
+    for (auto &u : us) {
+      u = vexp(e * vlog(1.0 - u));
+    }
   }
 };
 
-// generate Zeta/Zipf-distributed integral values
+// generate Zeta/Zipf-distributed integral values, P(k) ~ k^-(α + 1) for
+// k >= minimum (1 by default), using rejection-inversion (see
+// "Rejection-inversion to generate variates from monotone discrete
+// distributions" by Hörmann and Derflinger). Values that do not fit into R
+// saturate to its maximum.
 template <std::integral R = std::int32_t> struct Zipf {
-  // generate a zipf distributed random variable using rejection sampling
-  // for a reference see "Non Iniform Random Variate Generation" by Devroye
-
   using result_type = R;
 
   std::uniform_real_distribution<> uniform{};
-  // Note that this is (s + 1) from wiki
   double alpha;
-  double b = std::pow(2, alpha);
+  double minimum;
+  // bounds of the range of H, see below
+  double H_lower = H(minimum + 0.5) - h(minimum);
+  double H_upper = 1.0 / alpha; // H(∞)
+  // candidates with k - x <= s are always accepted (for k >= 2)
+  double s = 2.0 - H_inverse(H(2.5) - h(2.0));
 
-  explicit Zipf(double alpha_) : alpha{alpha_} {
+  explicit Zipf(double alpha_, R minimum_ = 1)
+      : alpha{alpha_}, minimum{static_cast<double>(minimum_)} {
     if (alpha <= 0.0) {
       throw std::invalid_argument{"Alpha needs to be larger than 0."};
     }
+    if (minimum_ < 1) {
+      throw std::invalid_argument{"Minimum needs to be at least 1."};
+    }
   };
 
   template <std::uniform_random_bit_generator RNG>
   auto operator()(RNG &rng) -> R {
-    // the rejection-rate is smaller than 1.5, so this will not loop too much
+    // the acceptance rate is above 0.98 for any alpha, and one uniform
+    // is needed per attempt
     while (true) {
-      const double u = uniform(rng);
-      // For a small result_type, this may round when alpha is small
-      const result_type X = static_cast<result_type>(std::pow(u, -1.0 / alpha));
-      const long double T = std::pow(1 + 1.0 / X, alpha);
-      const double v = uniform(rng);
-      if (v * X * (T - 1) / (b - 1) <= T / b) {
-        return X;
+      const auto u = sample_u(rng);
+      const auto x = H_inverse(u);
+      if (const auto k = candidate(x); accept(k, x, u)) {
+        return saturate(k);
       }
     }
   }
+
+  // fill a block at once: candidates are computed with the vectorizable
+  // vlog/vexp, the (rare) rejected ones are redrawn one by one
+  template <std::uniform_random_bit_generator RNG>
+  auto fill(std::span<R> out, RNG &rng) -> void {
+    constexpr std::size_t block = 64;
+    auto us = std::array<double, block>{};
+    auto xs = std::array<double, block>{};
+    for (std::size_t begin = 0; begin < out.size(); begin += block) {
+      const auto n = std::min(block, out.size() - begin);
+      for (std::size_t i = 0; i < n; ++i) {
+        us[i] = sample_u(rng);
+      }
+      const auto a = alpha;
+      for (std::size_t i = 0; i < block; ++i) {
+        xs[i] = vexp(-vlog(1.0 - a * us[i]) / a);
+      }
+      for (std::size_t i = 0; i < n; ++i) {
+        const auto k = candidate(xs[i]);
+        out[begin + i] = accept(k, xs[i], us[i]) ? saturate(k) : (*this)(rng);
+      }
+    }
+  }
+
+private:
+  // the density is h(x) = x^-(α + 1), and H(x) = (1 - x^-α) / α is its
+  // integral from 1 to x
+  auto h(double x) const -> double {
+    return std::exp(-(alpha + 1) * std::log(x));
+  }
+
+  auto H(double x) const -> double {
+    return -std::expm1(-alpha * std::log(x)) / alpha;
+  }
+
+  auto H_inverse(double u) const -> double {
+    return std::exp(-std::log1p(-alpha * u) / alpha);
+  }
+
+  template <std::uniform_random_bit_generator RNG>
+  auto sample_u(RNG &rng) -> double {
+    // in (H_lower, H_upper]
+    return H_upper + uniform(rng) * (H_lower - H_upper);
+  }
+
+  auto candidate(double x) const -> double {
+    return std::max(std::floor(x + 0.5), minimum);
+  }
+
+  auto accept(double k, double x, double u) const -> bool {
+    return k - x <= s || u >= H(k + 0.5) - h(k);
+  }
+
+  static auto saturate(double k) -> R {
+    constexpr auto max = std::numeric_limits<R>::max();
+    return k < static_cast<double>(max) ? static_cast<R>(k) : max;
+  }
 };
 
 } // namespace lerw
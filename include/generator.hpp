@@ -1,55 +1,276 @@
 #pragma once
 
+#include <concepts>
+#include <optional>
 #include <random>
+#include <utility>
+#include <vector>
 
 #include "concepts.hpp" // IWYU pragma: keep
-#include "hash_set.hpp"
+#include "visited.hpp"
 
 namespace lerw {
 
-template <stopper Stopper, stepper Stepper> struct RandomWalkGenerator {
+template <class Point> struct WalkEnd {
+  Point point;
+  // number of points of the walk, including the origin
+  std::size_t length;
+};
+
+template <class Stopper, stepper Stepper>
+  requires stopper<Stopper> ||
+           incremental_stopper<Stopper, typename Stepper::Point>
+struct RandomWalkGenerator {
+  using Point = Stepper::Point;
+
   Stopper stopper;
   Stepper stepper;
 
   template <std::uniform_random_bit_generator RNG>
   constexpr auto operator()(RNG &rng) -> auto {
-    std::vector walk{zero<typename Stepper::Point>()};
+    std::vector walk{zero<Point>()};
 
-    while (not stopper(walk))
-      walk.emplace_back(stepper(walk.back(), rng));
+    if constexpr (whole_walk) {
+      while (not stopper(walk))
+        walk.emplace_back(stepper(walk.back(), rng));
+    } else {
+      while (not stopper.on_step(walk.back()))
+        walk.emplace_back(stepper(walk.back(), rng));
+    }
 
     return walk;
   }
+
+  // the same walk, without storing it, e.g. for exit times. Stateful
+  // stoppers (with on_step) need a generator per walk.
+  template <std::uniform_random_bit_generator RNG>
+    requires incremental_stopper<Stopper, Point>
+  constexpr auto end(RNG &rng) -> WalkEnd<Point> {
+    auto end = WalkEnd<Point>{zero<Point>(), 1};
+    while (not stopper.on_step(end.point)) {
+      end.point = stepper(end.point, rng);
+      ++end.length;
+    }
+    return end;
+  }
+
+private:
+  // prefer looking at the whole walk, which keeps no state
+  static constexpr bool whole_walk = lerw::stopper<Stopper>;
+};
+
+// The memory a thread reuses for all its walks: the walk and its visited
+// points. clear() keeps the capacity, so that the next walk does not grow
+// (and rehash) them again, unless the last walk was an outlier, much longer
+// than the typical one. Then the memory is given back. The visited set is
+// checked on its own: the maps keep the erased points, so a walk whose loops
+// were erased may still leave a huge map behind.
+template <class Point, class Visited> struct Workspace {
+  std::vector<Point> walk{};
+  Visited visited{};
+  // moving averages of the walk lengths and the capacities of visited,
+  // starting at those of the first walk
+  double typical_length = 0.0;
+  double typical_capacity = 0.0;
+  bool seeded = false;
+
+  // walks (and sets) smaller than this never count as outliers
+  static constexpr std::size_t min_outlier = 1 << 16;
+
+  auto clear() -> void {
+    const auto length = walk.size();
+    const auto capacity = visited.capacity();
+    if (not seeded) {
+      // the first walk is typical, whatever its size
+      typical_length = static_cast<double>(length);
+      typical_capacity = static_cast<double>(capacity);
+      seeded = true;
+    } else if (outlier(length, typical_length) ||
+               outlier(capacity, typical_capacity)) {
+      walk = std::vector<Point>{};
+      visited.shrink();
+    }
+    typical_length = 0.9 * typical_length + 0.1 * static_cast<double>(length);
+    typical_capacity =
+        0.9 * typical_capacity + 0.1 * static_cast<double>(capacity);
+    walk.clear();
+    visited.clear();
+  }
+
+private:
+  static auto outlier(std::size_t size, double typical) -> bool {
+    return size > min_outlier && static_cast<double>(size) > 16 * typical;
+  }
 };
 
-template <stopper Stopper, stepper Stepper>
+// VisitedSet is one of the backends in visited.hpp, either a map from
+// points to their index in the walk or a set of the points on the walk
+template <stopper Stopper, stepper Stepper,
+          class VisitedSet = HashVisited<typename Stepper::Point>>
 struct LoopErasedRandomWalkGenerator {
+  using Point = Stepper::Point;
+  // for maps, erased points are not removed: an entry only counts if walk
+  // still holds the point at that index
+  using Visited = VisitedSet;
+  using Workspace = lerw::Workspace<Point, Visited>;
+
   Stopper stopper;
   Stepper stepper;
+  // End the walks without drawing the direction of their last step, where
+  // its length alone shows that it leaves the domain of the stopper (see
+  // LDStepper). The walk then ends with a point outside that stands in for
+  // the exit point, and is not inserted into visited. Every walk has its
+  // own RNG, so the lengths are the same. Ignored where the stepper or the
+  // stopper cannot tell.
+  bool skip_exits = false;
 
   template <std::uniform_random_bit_generator RNG>
+    requires std::default_initializable<Visited>
   constexpr auto operator()(RNG &rng) -> auto {
-    using Point = Stepper::Point;
-    const auto start = zero<Point>();
-    hash_set<Point> visited{start};
-    std::vector walk{start};
+    Workspace workspace{};
+    (*this)(rng, workspace);
+    return std::move(workspace.walk);
+  }
+
+  // reuses the memory of workspace, e.g. across the walks of a thread. The
+  // walk is valid until the workspace is used again.
+  template <std::uniform_random_bit_generator RNG>
+  constexpr auto operator()(RNG &rng, Workspace &workspace)
+      -> const std::vector<Point> & {
+    reset(workspace);
+    auto &walk = workspace.walk;
 
     while (not stopper(walk)) {
-      auto proposed = stepper(walk.back(), rng);
-      auto [_, inserted] = visited.insert(proposed);
+      if (auto next = propose(walk.back(), rng)) {
+        add(walk, workspace.visited, std::move(*next));
+      } else {
+        walk.push_back(exit_point());
+      }
+    }
 
-      if (inserted) [[likely]] {
-        walk.emplace_back(std::move(proposed));
-        continue;
+    return walk;
+  }
+
+  // the point after p, or nothing if the walk certainly leaves (only with
+  // skip_exits)
+  template <std::uniform_random_bit_generator RNG>
+  constexpr auto propose(const Point &p, RNG &rng) -> std::optional<Point> {
+    if constexpr (can_skip_exits) {
+      if (skip_exits) {
+        return stepper(p, rng, std::as_const(stopper));
       }
+    }
+    return stepper(p, rng);
+  }
 
-      while (walk.back() != proposed) {
+  // stands in for the exit point when propose gives nothing
+  constexpr auto exit_point() const -> Point {
+    if constexpr (can_skip_exits) {
+      return stopper.template exit_point<Point>();
+    } else {
+      std::unreachable();
+    }
+  }
+
+  static constexpr auto reset(Workspace &workspace) -> void {
+    const auto start = zero<Point>();
+    workspace.clear();
+    workspace.walk.push_back(start);
+    if constexpr (set_backend) {
+      workspace.visited.insert(start);
+    } else {
+      workspace.visited[start] = 0;
+    }
+  }
+  // append proposed to walk, erasing the loop it closes
+  static constexpr auto add(std::vector<Point> &walk, Visited &visited,
+                            Point proposed) -> void {
+    if constexpr (set_backend) {
+      if (visited.insert(proposed)) [[likely]] {
+        walk.emplace_back(std::move(proposed));
+        return;
+      }
+      // every point is popped at most once after it was pushed, so this is
+      // amortized O(1) as well
+      while (not(walk.back() == proposed)) {
         visited.erase(walk.back());
         walk.pop_back();
       }
+    } else {
+      auto &index = visited[proposed];
+
+      if (index < walk.size() && walk[index] == proposed) {
+        // erase the loop
+        walk.resize(index + 1);
+        return;
+      }
+
+      // new, or a stale entry from an erased loop
+      index = static_cast<Visited::index_type>(walk.size());
+      walk.emplace_back(std::move(proposed));
     }
+  }
 
-    return walk;
+private:
+  // sets (like TileVisited) only know whether a point is on the walk
+  static constexpr bool set_backend =
+      requires(Visited &v, const Point &p) { v.erase(p); };
+  static constexpr bool can_skip_exits =
+      requires(Stepper &s, const Stopper &domain, const Point &p,
+               std::mt19937 &rng) {
+        { s(p, rng, domain) } -> std::same_as<std::optional<Point>>;
+        { domain.template exit_point<Point>() } -> std::same_as<Point>;
+      };
+};
+
+// A loop-erased walk that is advanced one step at a time, so that several
+// of them can be interleaved on one thread: propose() draws the next point
+// and prefetches its slot in visited, add() inserts it later, once the
+// other walks had their turn and the slot is (hopefully) in cache.
+// Steps happen in the same order as in LoopErasedRandomWalkGenerator, so
+// the walk is the same.
+template <class Generator, std::uniform_random_bit_generator RNG>
+struct LoopErasedWalk {
+  using Point = Generator::Point;
+  using Workspace = Generator::Workspace;
+
+  Generator generator;
+  RNG rng;
+  // taken over from the previous walk, to reuse its memory
+  Workspace workspace;
+  Point proposed = zero<Point>();
+  // proposed is the stand-in for the exit point (see skip_exits)
+  bool exits = false;
+
+  LoopErasedWalk(Generator generator_, RNG rng_, Workspace workspace_)
+      : generator{std::move(generator_)}, rng{std::move(rng_)},
+        workspace{std::move(workspace_)} {
+    Generator::reset(workspace);
+  }
+
+  auto walk() const -> const std::vector<Point> & { return workspace.walk; }
+
+  // false once the walk is stopped
+  auto propose() -> bool {
+    if (generator.stopper(workspace.walk)) {
+      return false;
+    }
+    if (auto next = generator.propose(workspace.walk.back(), rng)) {
+      proposed = std::move(*next);
+      workspace.visited.prefetch(proposed);
+    } else {
+      proposed = generator.exit_point();
+      exits = true;
+    }
+    return true;
+  }
+
+  auto add() -> void {
+    if (exits) {
+      workspace.walk.push_back(std::move(proposed));
+      return;
+    }
+    Generator::add(workspace.walk, workspace.visited, std::move(proposed));
   }
 };
 
@@ -1,15 +1,198 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <gtl/phmap.hpp>
+#include <utility>
+#include <vector>
+
+#if __has_include(<boost/unordered/unordered_flat_set.hpp>)
+#include <boost/unordered/unordered_flat_set.hpp>
+#define LERW_HAS_BOOST_FLAT_SET 1
+#endif
+
+// --- adapter to gtl internals ---------------------------------------------
+// gtl's public prefetch() does nothing in the vendored version (its body is
+// disabled upstream), so this reaches the first group of the probe sequence
+// through HashtableDebugAccess, gtl's debug hook, which is a friend of its
+// tables. That hook and the members used here (probe, hash, ctrl_, slots_)
+// are internals, so check them again when updating gtl, and use its
+// prefetch() once it does something. Nothing else in lerw touches them.
+static_assert(GTL_VERSION_MAJOR == 1 && GTL_VERSION_MINOR == 2 &&
+                  GTL_VERSION_PATCH == 0,
+              "prefetch_slot was written against gtl 1.2.0, see above");
 
 namespace lerw {
+struct GtlPrefetch;
+} // namespace lerw
 
-template <class T> using hash_set = gtl::flat_hash_set<T>;
+namespace gtl::priv::hashtable_debug_internal {
+
+template <class Set> struct HashtableDebugAccess<Set, lerw::GtlPrefetch> {
+  template <class Key>
+  static auto prefetch(const Set &set, const Key &key) -> void {
+    const auto offset = set.probe(set.hash(key)).offset();
+    __builtin_prefetch(set.ctrl_ + offset);
+    __builtin_prefetch(set.slots_ + offset);
+  }
+};
+
+} // namespace gtl::priv::hashtable_debug_internal
+// --- end of the adapter to gtl internals ----------------------------------
+
+namespace lerw {
+
+template <class T, class Hash = std::hash<T>>
+using hash_set = gtl::flat_hash_set<T, Hash>;
+template <class K, class V, class Hash = std::hash<K>>
+using hash_map = gtl::flat_hash_map<K, V, Hash>;
+
+// prefetches the slot of key in a hash_set or hash_map, for inserting it
+// soon (through the adapter above)
+template <class Set, class Key>
+  requires requires { typename Set::raw_hash_set; }
+auto prefetch_slot(const Set &set, const Key &key) -> void {
+  gtl::priv::hashtable_debug_internal::HashtableDebugAccess<
+      Set, GtlPrefetch>::prefetch(set, key);
+}
+
+#ifdef LERW_HAS_BOOST_FLAT_SET
+// needs boost >= 1.81
+template <class T, class Hash = std::hash<T>>
+using boost_hash_set = boost::unordered_flat_set<T, Hash>;
+#endif
 
 template <class T>
 concept hashable = std::equality_comparable<T> && requires(T t) {
   { std::hash<T>{}(t) } -> std::same_as<std::size_t>;
 };
 
+// Open addressing with linear probing, for the pattern of loop erasure:
+// points are erased in the reverse order of their insertion. Erasing uses
+// backward shifting instead of tombstones, and since the last inserted key
+// usually sits at the end of its probe sequence, there is rarely anything
+// to shift. It has the interface of the visited sets in visited.hpp.
+template <hashable Key, class Hash = std::hash<Key>> struct LifoHashSet {
+  std::vector<Key> slots{};
+  std::vector<std::uint8_t> used{};
+
+  auto size() const -> std::size_t { return count; }
+  auto empty() const -> bool { return count == 0; }
+  auto capacity() const -> std::size_t { return slots.size(); }
+
+  auto contains(const Key &key) const -> bool {
+    return not empty() && used[find(key)];
+  }
+
+  // false if key was in the set already
+  auto insert(const Key &key) -> bool {
+    // keep the load below 1/2, so that probe sequences stay short
+    if (2 * (count + 1) > capacity()) {
+      grow();
+    }
+    const auto i = find(key);
+    if (used[i]) {
+      return false;
+    }
+    slots[i] = key;
+    used[i] = 1;
+    ++count;
+    return true;
+  }
+
+  auto erase(const Key &key) -> void {
+    if (empty()) {
+      return;
+    }
+    auto hole = find(key);
+    if (not used[hole]) {
+      return;
+    }
+    // move later keys of the probe sequence into the hole, if the hole lies
+    // between their home and their slot
+    for (auto j = next(hole); used[j]; j = next(j)) {
+      const auto home = index(slots[j]);
+      if (((j - home) & mask) >= ((j - hole) & mask)) {
+        slots[hole] = std::move(slots[j]);
+        hole = j;
+      }
+    }
+    used[hole] = 0;
+    --count;
+  }
+
+  auto prefetch(const Key &key) const -> void {
+    if (not empty()) {
+      const auto i = index(key);
+      __builtin_prefetch(&used[i]);
+      __builtin_prefetch(&slots[i]);
+    }
+  }
+
+  // number of slots between the home of key and its slot (or the empty slot
+  // where it would go), to measure hashes
+  auto probe_length(const Key &key) const -> std::size_t {
+    return empty() ? 0 : (find(key) - index(key)) & mask;
+  }
+
+  auto clear() -> void {
+    std::fill(used.begin(), used.end(), 0);
+    count = 0;
+  }
+
+  auto shrink() -> void { *this = LifoHashSet{}; }
+
+private:
+  std::size_t count = 0;
+  std::size_t mask = 0;
+  int shift = 64;
+
+  // Fibonacci hashing, since std::hash is the identity for integers. Hashes
+  // that are mixed already (is_avalanching, as for boost::unordered) or
+  // meant to keep locality (is_local) are used as they are.
+  auto index(const Key &key) const -> std::size_t {
+    const auto h = std::uint64_t{Hash{}(key)};
+    if constexpr (requires { typename Hash::is_avalanching; } ||
+                  requires { typename Hash::is_local; }) {
+      return static_cast<std::size_t>(h) & mask;
+    } else {
+      return (h * 0x9E3779B97F4A7C15) >> shift;
+    }
+  }
+
+  auto next(std::size_t i) const -> std::size_t { return (i + 1) & mask; }
+
+  // the slot of key, or the empty slot where it would go
+  auto find(const Key &key) const -> std::size_t {
+    auto i = index(key);
+    while (used[i] && not(slots[i] == key)) {
+      i = next(i);
+    }
+    return i;
+  }
+
+  auto grow() -> void {
+    auto old_slots = std::exchange(slots, {});
+    auto old_used = std::exchange(used, {});
+    const auto n = std::max<std::size_t>(16, 2 * old_slots.size());
+    slots.resize(n);
+    used.assign(n, 0);
+    mask = n - 1;
+    shift = 64 - std::countr_zero(n);
+    count = 0;
+    for (std::size_t i = 0; i < old_slots.size(); ++i) {
+      if (old_used[i]) {
+        const auto j = find(old_slots[i]);
+        slots[j] = std::move(old_slots[i]);
+        used[j] = 1;
+        ++count;
+      }
+    }
+  }
+};
+
 } // namespace lerw
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <concepts> // IWYU pragma: keep // std::uniform_random_bit_generator
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/math/special_functions/zeta.hpp>
+
+#include "alias.hpp"
+#include "concepts.hpp"
+#include "ldstepper.hpp"
+#include "shells.hpp"
+#include "utils.hpp"
+
+namespace lerw {
+
+// The distribution of the steps of LDStepper{Zipf{α}, direction} for the
+// L1 or LINF direction, over the displacements x themselves: with k = |x|,
+// P(x) = P(k) / |S_k|, where P(k) ~ k^-(α + 1) and S_k is the sphere of
+// radius k. The displacements up to a radius, and the tail (all longer ones
+// together), are the columns of an alias table.
+template <point Point> struct JumpTable {
+  std::vector<Point> jumps;
+  // index jumps.size() is the tail
+  AliasTable alias;
+
+  // the coordinates of Shells are 8 bits
+  static constexpr int max_radius = 127;
+  // (e.g. radius 64 in 4 dimensions with LINF would be too many)
+  static constexpr std::size_t max_jumps = std::size_t{1} << 24;
+
+  template <Norm n>
+  static auto zipf(double alpha, int radius) -> JumpTable {
+    if (radius < 1 || radius > max_radius) {
+      throw std::invalid_argument{"Jump radius needs to be in [1, 127]."};
+    }
+    using shells = Shells<dim<Point>(), n>;
+    if (shells::ball_size(radius) > max_jumps) {
+      throw std::invalid_argument{"Jump radius too large for the dimension."};
+    }
+
+    auto jumps = std::vector<Point>{};
+    // the number of displacements of each length
+    auto sizes = std::vector<double>(static_cast<std::size_t>(radius) + 1);
+    shells::for_each_point(radius, [&jumps, &sizes](const auto &x) {
+      if (const auto k = shells::length(x); k > 0) {
+        jumps.push_back(constructor<Point>{}(x.cbegin(), x.cend()));
+        sizes[static_cast<std::size_t>(k)] += 1;
+      }
+    });
+
+    const auto s = alpha + 1;
+    auto weights = std::vector<double>{};
+    weights.reserve(jumps.size() + 1);
+    for (const auto &x : jumps) {
+      const auto k = norm<n>(x);
+      weights.push_back(std::pow(k, -s) / sizes[static_cast<std::size_t>(k)]);
+    }
+    // P(k > radius) up to the same factor, i.e. zeta(s) without the first
+    // terms. (When the difference cancels, it is below the rounding of the
+    // table anyway.)
+    auto tail = boost::math::zeta(s);
+    for (int k = 1; k <= radius; ++k) {
+      tail -= std::pow(k, -s);
+    }
+    weights.push_back(std::max(tail, 0.0));
+
+    return {std::move(jumps), AliasTable{weights}};
+  }
+};
+
+// Steps like LDStepper{Zipf{α}, direction}, but the steps up to the radius
+// of the table cost one draw from the table. The tail goes to the
+// LDStepper, whose lengths start above the radius then
+// (Zipf{α, radius + 1}). Without a table, every step is one of the
+// LDStepper.
+template <distribution Length, direction Direction> struct JumpStepper {
+  using Point = Direction::result_type;
+
+  // shared by the steppers of all walks
+  std::shared_ptr<const JumpTable<Point>> table;
+  LDStepper<Length, Direction> stepper;
+
+  explicit JumpStepper(std::shared_ptr<const JumpTable<Point>> jump_table,
+                       Length &&step_length, Direction &&step_direction)
+      : table{std::move(jump_table)},
+        stepper{std::move(step_length), std::move(step_direction)} {}
+
+  template <std::uniform_random_bit_generator RNG>
+  auto operator()(const Point &p, RNG &rng) -> Point {
+    if (table) {
+      if (const auto i = table->alias(rng); i < table->jumps.size()) {
+        return p + table->jumps[i];
+      }
+    }
+    return stepper(p, rng);
+  }
+
+  // see LDStepper. Only the tail is checked: the jumps of the table are
+  // short, and cheap anyway.
+  template <class Domain, std::uniform_random_bit_generator RNG>
+  auto operator()(const Point &p, RNG &rng, const Domain &domain)
+      -> std::optional<Point> {
+    if (table) {
+      if (const auto i = table->alias(rng); i < table->jumps.size()) {
+        return p + table->jumps[i];
+      }
+    }
+    return stepper(p, rng, domain);
+  }
+};
+
+} // namespace lerw
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "concepts.hpp"
+#include "hash_set.hpp"
+
+namespace lerw {
+
+// Hashes for points of the integer lattice. std::hash of an int is the
+// identity, so combining the coordinates by xor (as the std::hash
+// specializations in point.hpp do) makes nearby points collide, e.g.
+// (256, 0) and (0, 1) in 2D. Instead, the coordinates are packed into one
+// 64 bit word, which is then mixed.
+
+// a multiply-xorshift mixer (the finalizer of splitmix64): every bit of the
+// input affects every bit of the output
+constexpr auto mix(std::uint64_t x) -> std::uint64_t {
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+  return x ^ (x >> 31);
+}
+
+// bits per coordinate when packing a point into 64 bits
+template <class Point> constexpr auto packed_bits() -> unsigned {
+  return static_cast<unsigned>(64 / dim<Point>());
+}
+
+// the low packed_bits() bits of each coordinate, one after the other. Only
+// injective if all coordinates fit (e.g. |x| < 2^20 in 3D), which is all a
+// hash needs. For more than 64 dimensions, the later coordinates are dropped.
+template <class Point> constexpr auto pack(const Point &p) -> std::uint64_t {
+  constexpr auto bits = packed_bits<Point>();
+  constexpr auto mask = bits == 64 ? ~std::uint64_t{0}
+                                   : (std::uint64_t{1} << bits) - 1;
+  auto packed = std::uint64_t{0};
+  for (const auto x : coordinates(p)) {
+    if constexpr (bits < 64) {
+      packed <<= bits;
+    }
+    packed |= static_cast<std::uint64_t>(static_cast<std::int64_t>(x)) & mask;
+  }
+  return packed;
+}
+
+// the bits of the coordinates interleaved, so that points close on the
+// lattice are mostly close in the order of the codes (the Morton or
+// Z-order). The coordinates are offset by 2^(packed_bits() - 1), so that
+// the codes grow with each coordinate, negative ones included.
+template <class Point> constexpr auto morton(const Point &p) -> std::uint64_t {
+  constexpr auto d = dim<Point>();
+  constexpr auto bits = packed_bits<Point>();
+  const auto x = coordinates(p);
+  const auto field = [&x](std::size_t i) -> std::uint64_t {
+    const auto value =
+        static_cast<std::uint64_t>(static_cast<std::int64_t>(x[i]));
+    if constexpr (bits == 64) {
+      return value ^ (std::uint64_t{1} << 63);
+    } else {
+      return (value ^ (std::uint64_t{1} << (bits - 1))) &
+             ((std::uint64_t{1} << bits) - 1);
+    }
+  };
+
+  if constexpr (d == 2) {
+    const auto spread = [](std::uint64_t v) {
+      v = (v | v << 16) & 0x0000FFFF0000FFFF;
+      v = (v | v << 8) & 0x00FF00FF00FF00FF;
+      v = (v | v << 4) & 0x0F0F0F0F0F0F0F0F;
+      v = (v | v << 2) & 0x3333333333333333;
+      return (v | v << 1) & 0x5555555555555555;
+    };
+    return spread(field(0)) << 1 | spread(field(1));
+  } else if constexpr (d == 3) {
+    const auto spread = [](std::uint64_t v) {
+      v = (v | v << 32) & 0x001F00000000FFFF;
+      v = (v | v << 16) & 0x001F0000FF0000FF;
+      v = (v | v << 8) & 0x100F00F00F00F00F;
+      v = (v | v << 4) & 0x10C30C30C30C30C3;
+      return (v | v << 2) & 0x1249249249249249;
+    };
+    return spread(field(0)) << 2 | spread(field(1)) << 1 | spread(field(2));
+  } else {
+    auto code = std::uint64_t{0};
+    for (unsigned bit = bits; bit-- > 0;) {
+      for (std::size_t i = 0; i < d && i < 64; ++i) {
+        code = code << 1 | (field(i) >> bit & 1);
+      }
+    }
+    return code;
+  }
+}
+
+// is_avalanching tells boost::unordered not to mix the hash again
+struct PackedHash {
+  using is_avalanching = std::true_type;
+
+  template <class Point>
+  constexpr auto operator()(const Point &p) const -> std::size_t {
+    return static_cast<std::size_t>(mix(pack(p)));
+  }
+};
+
+// Not mixed, so that a container indexing with the low bits (LifoHashSet
+// does for hashes with is_local) puts a tile of 2^k consecutive codes into
+// consecutive slots. Containers that mix the hash (gtl) lose the locality.
+struct MortonHash {
+  using is_local = std::true_type;
+
+  template <class Point>
+  constexpr auto operator()(const Point &p) const -> std::size_t {
+    return static_cast<std::size_t>(morton(p));
+  }
+};
+
+struct HashStatistics {
+  // fraction of the points whose hash equals that of another point
+  double collision_rate;
+  // probe lengths of the lookups of all points in a LifoHashSet holding them
+  double mean_probe_length;
+  std::size_t max_probe_length;
+};
+
+// measure a hash on the points of a walk (visited more than once or not)
+template <class Hash, class Point>
+auto hash_statistics(const std::vector<Point> &points) -> HashStatistics {
+  auto set = LifoHashSet<Point, Hash>{};
+  auto hashes = std::vector<std::size_t>{};
+  for (const auto &p : points) {
+    if (set.insert(p)) {
+      hashes.push_back(Hash{}(p));
+    }
+  }
+  if (hashes.empty()) {
+    return {0.0, 0.0, 0};
+  }
+
+  // every point of a run of equal hashes longer than 1 collides
+  std::ranges::sort(hashes);
+  auto colliding = std::size_t{0};
+  for (auto run = hashes.cbegin(); run != hashes.cend();) {
+    const auto end = std::ranges::upper_bound(run, hashes.cend(), *run);
+    if (end - run > 1) {
+      colliding += static_cast<std::size_t>(end - run);
+    }
+    run = end;
+  }
+
+  auto total = std::size_t{0};
+  auto longest = std::size_t{0};
+  for (const auto &p : points) {
+    const auto length = set.probe_length(p);
+    total += length;
+    longest = std::max(longest, length);
+  }
+  const auto n = static_cast<double>(hashes.size());
+  return {static_cast<double>(colliding) / n,
+          static_cast<double>(total) / static_cast<double>(points.size()),
+          longest};
+}
+
+} // namespace lerw
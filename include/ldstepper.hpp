@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <concepts> // IWYU pragma: keep // std::uniform_random_bit_generator
+#include <optional>
 #include <random>
 
 #include "concepts.hpp"
@@ -21,6 +22,19 @@ template <distribution Length, direction Direction> struct LDStepper {
   auto operator()(const Point &p, RNG &rng) -> Point {
     return p + direction(length(rng), rng);
   }
+
+  // the same step, or nothing if its length alone shows that it leaves the
+  // domain (a stopper, see DistanceStopper::leaves): then, the direction is
+  // not drawn
+  template <class Domain, std::uniform_random_bit_generator RNG>
+  auto operator()(const Point &p, RNG &rng, const Domain &domain)
+      -> std::optional<Point> {
+    const auto l = length(rng);
+    if (domain.leaves(p, static_cast<double>(l))) {
+      return std::nullopt;
+    }
+    return p + direction(l, rng);
+  }
 };
 
 } // namespace lerw
@@ -1,47 +1,74 @@
 #include <algorithm>
 #include <bits/ranges_algo.h>
 #include <cassert>
-#include <execution>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
-#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/partitioner.h>
+#include <tbb/task_arena.h>
+
 #include "array_point.hpp"
 #include "directions.hpp"
 #include "distributions.hpp"
 #include "generator.hpp"
+#include "jumpstepper.hpp"
 #include "ldstepper.hpp"
+#include "packed_point.hpp"
 #include "point.hpp"
+#include "rng.hpp"
 #include "stopper.hpp"
 #include "utils.hpp"
+#include "visited.hpp"
 
 namespace lerw {
 
-template <std::size_t Dim>
+// T is the type of the coordinates, Packed selects a point packed into 64
+// bits (packed_point.hpp), where there is one
+template <std::size_t Dim, class T = int_t, bool Packed = false>
   requires(Dim > 0)
 struct PointTypeSelector {
-  using type = ArrayPoint<Dim>;
+  using type = ArrayPoint<Dim, T>;
+};
+
+template <class T, bool Packed> struct PointTypeSelector<1, T, Packed> {
+  using type = BasicPoint1D<T>;
+};
+
+template <class T> struct PointTypeSelector<2, T> {
+  using type = BasicPoint2D<T>;
 };
 
-template <> struct PointTypeSelector<1> {
-  using type = Point1D;
+template <> struct PointTypeSelector<2, int_t, true> {
+  using type = PackedPoint2D;
 };
 
-template <> struct PointTypeSelector<2> {
-  using type = Point2D;
+template <class T> struct PointTypeSelector<3, T> {
+  using type = BasicPoint3D<T>;
 };
 
-template <> struct PointTypeSelector<3> {
-  using type = Point3D;
+template <> struct PointTypeSelector<3, int_t, true> {
+  using type = PackedPoint3D;
 };
 
-template <std::size_t dim>
-using PointType = typename PointTypeSelector<dim>::type;
+template <std::size_t dim, class T = int_t, bool packed = false>
+using PointType = typename PointTypeSelector<dim, T, packed>::type;
 
 template <point P, Norm n> struct DirectionSelector;
 
 template <point P> struct DirectionSelector<P, Norm::L1> {
-  using type = L2Direction<P>;
+  using type = L1Direction<P>;
 };
 
 template <point P> struct DirectionSelector<P, Norm::L2> {
@@ -74,54 +101,430 @@ template <point P, Norm n>
 using LengthType = typename LengthSelector<P, n>::type;
 
 struct LERWComputer {
-  std::function<std::mt19937()> rng_factory;
+  std::uint64_t seed;
   std::size_t N;
   double alpha;
   double distance;
+  // number of walks run round-robin per thread, see
+  // compute_interleaved_observables
+  std::size_t interleave = 1;
+  VisitedBackend visited = VisitedBackend::automatic;
+  // use the points of packed_point.hpp where they give the same results
+  bool packed = false;
+  // 16, 32 or 64, or 0 for the narrowest that gives the same results (see
+  // fits_coordinates) and saves memory. 16 is only there from 3 dimensions
+  // on, and 16 and 64 only with some visited sets (see has_backend), to
+  // keep the number of instantiations down.
+  int coordinate_bits = 0;
+  // L1 and LINF steps up to this length are drawn from one alias table of
+  // all displacements (see jumpstepper.hpp), 0 for none. The walks are
+  // different ones, with the same distribution.
+  int jump_radius = 0;
+  // see LoopErasedRandomWalkGenerator::skip_exits (does not change the
+  // lengths)
+  bool skip_exits = false;
+
   template <std::size_t dim, Norm norm> auto compute() const {
-    using point_t = PointType<dim>;
-    return compute_lerw_lengths(
-        [alpha = alpha]() {
-          return LDStepper{LengthType<point_t, norm>{alpha}, DirectionType<point_t, norm>{}};
-        },
-        [distance = distance]() { return DistanceStopper<norm>{distance}; },
-        rng_factory, N);
+    return with_point<dim>(distance, [this]<point P>() {
+      return with_visited<P>(distance, [this](auto visited_factory) {
+        return compute_lerw_lengths(stepper_factory<P, norm>(),
+                                    [distance = distance]() {
+                                      return DistanceStopper<norm>{distance};
+                                    },
+                                    rng_factory(), N, interleave,
+                                    visited_factory, skip_exits);
+      });
+    });
+  }
+
+  // for every walk, the lengths when it first leaves each of the (sorted)
+  // distances
+  template <std::size_t dim, Norm norm>
+  auto compute(const std::vector<double> &distances) const {
+    return with_point<dim>(distances.back(), [this, &distances]<point P>() {
+      return with_visited<P>(
+          distances.back(), [this, &distances](auto visited_factory) {
+            return compute_lerw_observables(
+                stepper_factory<P, norm>(),
+                [&distances]() {
+                  return MultiDistanceStopper<norm>{distances};
+                },
+                rng_factory(), N,
+                [](const auto &stopper, const auto &) {
+                  return stopper.lengths;
+                },
+                interleave, visited_factory, skip_exits);
+          });
+    });
+  }
+
+  // the backend used for walks that stay within distance (apart from their
+  // last point)
+  template <std::size_t dim>
+  auto visited_backend(double max_distance) const -> VisitedBackend {
+    if (visited != VisitedBackend::automatic) {
+      return visited;
+    }
+    const auto threads =
+        static_cast<std::size_t>(tbb::this_task_arena::max_concurrency());
+    return choose_visited_backend<PointType<dim>>(max_distance, threads,
+                                                  available_memory());
+  }
+
+private:
+  // calls f with the point type to use
+  template <std::size_t dim, class F>
+  auto with_point(double max_distance, F &&f) const {
+    constexpr auto has_16_bits = dim >= 3;
+    auto bits = coordinate_bits;
+    if (bits == 0) {
+      // 16 bits only where the visited set stores the points
+      const auto narrow =
+          has_16_bits && fits_coordinates<std::int16_t>(max_distance) &&
+          has_backend<PointType<dim, std::int16_t>>(
+              visited_backend<dim>(max_distance));
+      bits = narrow                                           ? 16
+             : fits_coordinates<std::int32_t>(max_distance) ? 32
+                                                            : 64;
+    }
+    if (bits != 16 && bits != 32 && bits != 64) {
+      throw std::invalid_argument{"Coordinates have 16, 32 or 64 bits."};
+    }
+    if (bits == 16 && not has_16_bits) {
+      throw std::invalid_argument{"16 bit coordinates need 3 dimensions."};
+    }
+    // beyond 64 bits, walks would saturate inside the ball and never stop
+    if ((bits == 16 && not fits_coordinates<std::int16_t>(max_distance)) ||
+        (bits == 32 && not fits_coordinates<std::int32_t>(max_distance)) ||
+        (bits == 64 && not fits_coordinates<std::int64_t>(max_distance))) {
+      throw std::invalid_argument{"Distance too large for the coordinates."};
+    }
+
+    if constexpr (dim == 2 || dim == 3) {
+      // packed points have 32 bit coordinates (at most), and are preferred
+      // to the 16 bit ones of the automatic choice
+      using packed_t = PointType<dim, int_t, true>;
+      if (packed && (coordinate_bits == 0 || coordinate_bits == 32) &&
+          packed_t::fits(max_distance)) {
+        return f.template operator()<packed_t>();
+      }
+    }
+    if constexpr (has_16_bits) {
+      if (bits == 16) {
+        return f.template operator()<PointType<dim, std::int16_t>>();
+      }
+    }
+    if (bits == 64) {
+      return f.template operator()<PointType<dim, std::int64_t>>();
+    }
+    return f.template operator()<PointType<dim>>();
+  }
+
+  template <point point_t, Norm norm> auto stepper_factory() const {
+    if constexpr (norm == Norm::L2) {
+      if (jump_radius != 0) {
+        throw std::invalid_argument{"Jump tables need the L1 or LINF norm."};
+      }
+      return [alpha = alpha]() {
+        return LDStepper{LengthType<point_t, norm>{alpha},
+                         DirectionType<point_t, norm>{}};
+      };
+    } else {
+      using length_t = LengthType<point_t, norm>;
+      using coordinate_t = length_t::result_type;
+      using table_t = JumpTable<point_t>;
+      // built once, for all walks. The lengths of the LDStepper are the
+      // ones beyond the table.
+      auto table = std::shared_ptr<const table_t>{};
+      auto minimum = coordinate_t{1};
+      if (jump_radius != 0) {
+        table = std::make_shared<const table_t>(
+            table_t::template zipf<norm>(alpha, jump_radius));
+        minimum = static_cast<coordinate_t>(jump_radius + 1);
+      }
+      return [alpha = alpha, table, minimum]() {
+        return JumpStepper{table, length_t{alpha, minimum},
+                           DirectionType<point_t, norm>{}};
+      };
+    }
+  }
+
+  auto rng_factory() const {
+    return [seed = seed](std::size_t i) { return Philox4x32{seed, i}; };
+  }
+
+  // The visited sets instantiated for point_t: all for 32 bit coordinates.
+  // To keep the compile time down, only hash for 16 bit ones, since the
+  // narrow points save memory where the set stores them (the lattice and
+  // the tiles don't), and only the sets choose_visited_backend picks beyond
+  // any lattice for 64 bit ones.
+  template <point point_t>
+  static constexpr auto has_backend(VisitedBackend backend) -> bool {
+    using T = field<point_t>::type;
+    if constexpr (std::same_as<T, int_t>) {
+      return true;
+    } else if constexpr (sizeof(T) < sizeof(int_t) || dim<point_t>() > 3) {
+      return backend == VisitedBackend::hash;
+    } else {
+      return backend == VisitedBackend::tiles;
+    }
+  }
+
+  // calls f with a factory for the visited sets
+  template <point point_t, class F>
+  auto with_visited(double max_distance, F &&f) const {
+    auto backend = visited_backend<dim<point_t>()>(max_distance);
+    if (not has_backend<point_t>(backend)) {
+      if (visited != VisitedBackend::automatic) {
+        throw std::invalid_argument{
+            "Visited backend needs 32 bit coordinates."};
+      }
+      // for explicit coordinate_bits, any backend gives the same results
+      backend = has_backend<point_t>(VisitedBackend::tiles)
+                    ? VisitedBackend::tiles
+                    : VisitedBackend::hash;
+    }
+    if constexpr (has_backend<point_t>(VisitedBackend::lattice)) {
+      if (backend == VisitedBackend::lattice) {
+        const auto radius =
+            static_cast<std::int64_t>(std::floor(max_distance));
+        if (not LatticeVisited<point_t>::fits(radius)) {
+          throw std::invalid_argument{"Distance too large for the lattice."};
+        }
+        return f([radius] { return LatticeVisited<point_t>{radius}; });
+      }
+    }
+    if constexpr (has_backend<point_t>(VisitedBackend::tiles)) {
+      if (backend == VisitedBackend::tiles) {
+        return f([] { return TileVisited<point_t>{}; });
+      }
+    }
+    if constexpr (has_backend<point_t>(VisitedBackend::gtl_set)) {
+      if (backend == VisitedBackend::gtl_set) {
+        return f([] { return SetVisited<hash_set<point_t>>{}; });
+      }
+#ifdef LERW_HAS_BOOST_FLAT_SET
+      if (backend == VisitedBackend::boost_set) {
+        return f([] { return SetVisited<boost_hash_set<point_t>>{}; });
+      }
+#endif
+      if (backend == VisitedBackend::lifo_set) {
+        return f([] { return LifoHashSet<point_t>{}; });
+      }
+    }
+    if constexpr (has_backend<point_t>(VisitedBackend::hash)) {
+      return f([] { return HashVisited<point_t>{}; });
+    } else {
+      // excluded above
+      std::unreachable();
+    }
   }
 };
 
+// RNGFactory maps the index of a walk to the RNG for that walk,
+// Observe maps the stopper and the walk to the result for that walk.
+// If a WorkspaceFactory is given, every thread makes one workspace and
+// passes it to the generator for all its walks.
+template <class GeneratorFactory, class RNGFactory, class Observe,
+          class WorkspaceFactory = std::nullptr_t>
+auto compute_observables(GeneratorFactory &&generator_factory,
+                         RNGFactory &&rng_factory, size_t N, Observe &&observe,
+                         WorkspaceFactory &&workspace_factory = nullptr)
+    -> auto {
+  constexpr auto has_workspace =
+      not std::is_null_pointer_v<std::decay_t<WorkspaceFactory>>;
+  using generator_t = decltype(generator_factory());
+  using rng_t = decltype(rng_factory(std::size_t{}));
+  auto make_workspace = [&] {
+    if constexpr (has_workspace) {
+      return workspace_factory();
+    } else {
+      return nullptr;
+    }
+  };
+  using workspace_t = decltype(make_workspace());
+  using walk_t = decltype([] {
+    if constexpr (has_workspace) {
+      return std::type_identity<
+          std::invoke_result_t<generator_t &, rng_t &, workspace_t &>>{};
+    } else {
+      return std::type_identity<std::invoke_result_t<generator_t &, rng_t &>>{};
+    }
+  }())::type;
+  using result_t = std::decay_t<
+      std::invoke_result_t<Observe &, const decltype(generator_t::stopper) &,
+                           const walk_t &>>;
+  std::vector<result_t> results(N);
+  auto workspaces =
+      tbb::enumerable_thread_specific<workspace_t>{make_workspace};
+
+  // Generator and RNG are created inside the task, so memory scales with the
+  // number of threads instead of N. Since the run times are heavy-tailed,
+  // every walk is its own task and idle threads steal them.
+  tbb::parallel_for(
+      tbb::blocked_range<std::size_t>{0, N, 1},
+      [&](const tbb::blocked_range<std::size_t> &range) {
+        for (auto i = range.begin(); i != range.end(); ++i) {
+          auto generator = generator_factory();
+          auto rng = rng_factory(i);
+          const auto &walk = [&] -> decltype(auto) {
+            if constexpr (has_workspace) {
+              return generator(rng, workspaces.local());
+            } else {
+              return generator(rng);
+            }
+          }();
+          results[i] = observe(std::as_const(generator.stopper), walk);
+        }
+      },
+      tbb::simple_partitioner{});
+
+  return results;
+}
+
 template <class GeneratorFactory, class RNGFactory>
 auto compute_lengths(GeneratorFactory &&generator_factory,
                      RNGFactory &&rng_factory,
                      size_t N) -> std::vector<size_t> {
-  auto generators = std::vector<decltype(generator_factory())>{};
-  auto rngs = std::vector<decltype(rng_factory())>{};
+  return compute_observables(
+      std::forward<GeneratorFactory>(generator_factory),
+      std::forward<RNGFactory>(rng_factory), N,
+      [](const auto &, const auto &walk) { return walk.size(); });
+}
 
-  // This has to stay std::exectution::seq to prevent a race condition on the
-  // seed rng
-  std::generate_n(std::execution::seq, std::back_inserter(rngs), N,
-                  rng_factory);
-  std::generate_n(std::execution::seq, std::back_inserter(generators), N,
-                  generator_factory);
+// Like compute_observables, but every task runs up to `interleave`
+// loop-erased walks round-robin on its thread (see LoopErasedWalk), which
+// hides the cache misses of the visited maps once they outgrow the cache.
+// The walks are the same as with compute_observables.
+template <class GeneratorFactory, class RNGFactory, class Observe,
+          class WorkspaceFactory>
+auto compute_interleaved_observables(GeneratorFactory &&generator_factory,
+                                     RNGFactory &&rng_factory, size_t N,
+                                     std::size_t interleave, Observe &&observe,
+                                     WorkspaceFactory &&workspace_factory)
+    -> auto {
+  using generator_t = decltype(generator_factory());
+  using rng_t = decltype(rng_factory(std::size_t{}));
+  using walk_t = LoopErasedWalk<generator_t, rng_t>;
+  using workspace_t = generator_t::Workspace;
+  using result_t = std::decay_t<
+      std::invoke_result_t<Observe &, const decltype(generator_t::stopper) &,
+                           decltype(std::declval<walk_t>().walk())>>;
+  std::vector<result_t> results(N);
+  // workspaces of finished walks, for the next ones on the thread
+  auto pools = tbb::enumerable_thread_specific<std::vector<workspace_t>>{};
 
-  std::vector<size_t> lengths(N);
+  // tasks hold a few walks more than there are lanes, so that lanes
+  // whose walk finished early can pick up the next one
+  const auto grain = 4 * std::max(interleave, std::size_t{1});
+  tbb::parallel_for(
+      tbb::blocked_range<std::size_t>{0, N, grain},
+      [&](const tbb::blocked_range<std::size_t> &range) {
+        auto &pool = pools.local();
+        auto next = range.begin();
+        auto start = [&](std::size_t i) {
+          auto workspace = [&] {
+            if (pool.empty()) {
+              return workspace_t{workspace_factory()};
+            }
+            auto w = std::move(pool.back());
+            pool.pop_back();
+            return w;
+          }();
+          return std::optional{walk_t{generator_factory(), rng_factory(i),
+                                      std::move(workspace)}};
+        };
+        // lanes[j] runs walk indices[j]
+        auto lanes = std::vector<std::optional<walk_t>>{};
+        auto indices = std::vector<std::size_t>{};
+        for (; next != range.end() && lanes.size() < interleave; ++next) {
+          lanes.push_back(start(next));
+          indices.push_back(next);
+        }
 
-  std::transform(
-      std::execution::par_unseq, generators.begin(), generators.end(),
-      rngs.begin(), lengths.begin(),
-      [](auto generator, auto rng) { return generator(rng).size(); });
+        auto running = lanes.size();
+        while (running > 0) {
+          for (std::size_t j = 0; j < lanes.size(); ++j) {
+            auto &lane = lanes[j];
+            while (lane && not lane->propose()) {
+              results[indices[j]] =
+                  observe(std::as_const(lane->generator.stopper),
+                          lane->walk());
+              pool.push_back(std::move(lane->workspace));
+              if (next != range.end()) {
+                lane = start(next);
+                indices[j] = next++;
+              } else {
+                lane.reset();
+                --running;
+              }
+            }
+          }
+          for (auto &lane : lanes) {
+            if (lane) {
+              lane->add();
+            }
+          }
+        }
+      },
+      tbb::simple_partitioner{});
 
-  return lengths;
+  return results;
 }
 
-template <class StepperFactory, class StopperFactory, class RNGFactory>
+// VisitedFactory makes the visited set (see visited.hpp) for the workspace
+// of each thread. By default, that is HashVisited. For skip_exits, see
+// LoopErasedRandomWalkGenerator.
+template <class StepperFactory, class StopperFactory, class RNGFactory,
+          class Observe, class VisitedFactory = std::nullptr_t>
+auto compute_lerw_observables(StepperFactory &&stepper_factory,
+                              StopperFactory &&stopper_factory,
+                              RNGFactory &&rng_factory, std::size_t n_samples,
+                              Observe &&observe, std::size_t interleave = 1,
+                              VisitedFactory &&visited_factory = nullptr,
+                              bool skip_exits = false) -> auto {
+  using stepper_t = decltype(stepper_factory());
+  using stopper_t = decltype(stopper_factory());
+  auto make_visited = [&] {
+    if constexpr (std::is_null_pointer_v<std::decay_t<VisitedFactory>>) {
+      return HashVisited<typename stepper_t::Point>{};
+    } else {
+      return visited_factory();
+    }
+  };
+  using generator_t =
+      LoopErasedRandomWalkGenerator<stopper_t, stepper_t,
+                                    decltype(make_visited())>;
+  auto make_workspace = [&] {
+    return typename generator_t::Workspace{.visited = make_visited()};
+  };
+  auto generator_factory = [&stopper_factory, &stepper_factory,
+                            skip_exits] {
+    return generator_t{stopper_factory(), stepper_factory(), skip_exits};
+  };
+  if (interleave > 1) {
+    return compute_interleaved_observables(
+        generator_factory, rng_factory, n_samples, interleave,
+        std::forward<Observe>(observe), make_workspace);
+  }
+  return compute_observables(generator_factory, rng_factory, n_samples,
+                             std::forward<Observe>(observe), make_workspace);
+}
+
+template <class StepperFactory, class StopperFactory, class RNGFactory,
+          class VisitedFactory = std::nullptr_t>
 auto compute_lerw_lengths(StepperFactory &&stepper_factory,
                           StopperFactory &&stopper_factory,
-                          RNGFactory &&rng_factory,
-                          std::size_t n_samples) -> auto {
-  auto generator_factory = [&stopper_factory, &stepper_factory] {
-    return LoopErasedRandomWalkGenerator{stopper_factory(), stepper_factory()};
-  };
-  return compute_lengths(generator_factory, rng_factory, n_samples);
+                          RNGFactory &&rng_factory, std::size_t n_samples,
+                          std::size_t interleave = 1,
+                          VisitedFactory &&visited_factory = nullptr,
+                          bool skip_exits = false) -> auto {
+  return compute_lerw_observables(
+      std::forward<StepperFactory>(stepper_factory),
+      std::forward<StopperFactory>(stopper_factory),
+      std::forward<RNGFactory>(rng_factory), n_samples,
+      [](const auto &, const auto &walk) { return walk.size(); }, interleave,
+      std::forward<VisitedFactory>(visited_factory), skip_exits);
 }
 
 template <class GeneratorFactory, class RNGFactory>
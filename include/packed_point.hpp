@@ -0,0 +1,202 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <unordered_set> // IWYU pragma: keep // std::hash
+
+#include "concepts.hpp" // IWYU pragma: keep // zero<T>(), etc
+#include "point.hpp"
+#include "utils.hpp"
+
+namespace lerw {
+
+// Points packed into a single 64 bit word, so that the walk and the visited
+// set store, compare and hash plain integers.
+
+// x in the low, y in the high 32 bits
+struct PackedPoint2D {
+  std::uint64_t bits;
+
+  // the coordinates have the range of Point2D
+  static constexpr auto fits(double) -> bool { return true; }
+
+  static constexpr auto of(int_t x, int_t y) -> PackedPoint2D {
+    return {static_cast<std::uint32_t>(x) |
+            std::uint64_t{static_cast<std::uint32_t>(y)} << 32};
+  }
+
+  constexpr auto x() const -> int_t {
+    return static_cast<int_t>(static_cast<std::uint32_t>(bits));
+  }
+  constexpr auto y() const -> int_t {
+    return static_cast<int_t>(static_cast<std::uint32_t>(bits >> 32));
+  }
+
+  // saturating, as Point2D
+  constexpr auto operator+=(const PackedPoint2D &rhs) -> PackedPoint2D & {
+    return *this = of(saturating_add(x(), rhs.x()),
+                      saturating_add(y(), rhs.y()));
+  }
+
+  constexpr friend auto operator+(PackedPoint2D lhs,
+                                  const PackedPoint2D &rhs) -> PackedPoint2D {
+    lhs += rhs;
+    return lhs;
+  }
+
+  constexpr auto operator==(const PackedPoint2D &) const -> bool = default;
+};
+
+// 21 bits per coordinate, so coordinates need to be in [-2^20, 2^20). The
+// top bit marks points that left this range: they all are the same point,
+// "escaped", which stays escaped when moved and is at infinite distance.
+// So a walk stopped at a distance below 2^20 ends when it escapes, as it
+// would with Point3D.
+struct PackedPoint3D {
+  std::uint64_t bits;
+
+  static constexpr auto field_bits = 21;
+  static constexpr auto limit = std::int64_t{1} << (field_bits - 1);
+  static constexpr auto mask = (std::uint64_t{1} << field_bits) - 1;
+  static constexpr auto escape_bit = std::uint64_t{1} << 63;
+
+  static constexpr auto escaped() -> PackedPoint3D { return {escape_bit}; }
+
+  // whether walks stopped at distance give the same lengths as with Point3D
+  static constexpr auto fits(double distance) -> bool {
+    return distance < static_cast<double>(limit - 1);
+  }
+
+  static constexpr auto of(std::int64_t x, std::int64_t y,
+                           std::int64_t z) -> PackedPoint3D {
+    if (x < -limit || x >= limit || y < -limit || y >= limit || z < -limit ||
+        z >= limit) [[unlikely]] {
+      return escaped();
+    }
+    return {(static_cast<std::uint64_t>(x) & mask) |
+            (static_cast<std::uint64_t>(y) & mask) << field_bits |
+            (static_cast<std::uint64_t>(z) & mask) << (2 * field_bits)};
+  }
+
+  constexpr auto is_escaped() const -> bool { return bits & escape_bit; }
+
+  constexpr auto x() const -> int_t { return get<0>(); }
+  constexpr auto y() const -> int_t { return get<1>(); }
+  constexpr auto z() const -> int_t { return get<2>(); }
+
+  constexpr auto operator+=(const PackedPoint3D &rhs) -> PackedPoint3D & {
+    if (is_escaped() || rhs.is_escaped()) [[unlikely]] {
+      return *this = escaped();
+    }
+    *this = of(std::int64_t{x()} + rhs.x(), std::int64_t{y()} + rhs.y(),
+               std::int64_t{z()} + rhs.z());
+    return *this;
+  }
+
+  constexpr friend auto operator+(PackedPoint3D lhs,
+                                  const PackedPoint3D &rhs) -> PackedPoint3D {
+    lhs += rhs;
+    return lhs;
+  }
+
+  constexpr auto operator==(const PackedPoint3D &) const -> bool = default;
+
+private:
+  // shift the field to the top, and back with sign extension
+  template <int i> constexpr auto get() const -> int_t {
+    constexpr auto offset = i * field_bits;
+    return static_cast<int_t>(
+        static_cast<std::int64_t>(bits << (64 - field_bits - offset)) >>
+        (64 - field_bits));
+  }
+};
+
+template <Norm N> constexpr auto norm(PackedPoint2D p) -> double {
+  return norm<N>(p.x(), p.y());
+}
+
+template <Norm N> constexpr auto norm(PackedPoint3D p) -> double {
+  if (p.is_escaped()) [[unlikely]] {
+    return std::numeric_limits<double>::infinity();
+  }
+  return norm<N>(p.x(), p.y(), p.z());
+}
+
+constexpr auto coordinates(PackedPoint2D p) -> std::array<int_t, 2> {
+  return {p.x(), p.y()};
+}
+
+// escaped points are put as far out as possible, e.g. outside the lattice
+// of LatticeVisited
+constexpr auto coordinates(PackedPoint3D p) -> std::array<int_t, 3> {
+  if (p.is_escaped()) [[unlikely]] {
+    constexpr auto far = std::numeric_limits<int_t>::max();
+    return {far, far, far};
+  }
+  return {p.x(), p.y(), p.z()};
+}
+
+template <> constexpr auto zero<PackedPoint2D>() -> PackedPoint2D {
+  return {0};
+}
+template <> constexpr auto zero<PackedPoint3D>() -> PackedPoint3D {
+  return {0};
+}
+
+template <> constexpr auto dim<PackedPoint2D>() -> std::size_t { return 2; }
+template <> constexpr auto dim<PackedPoint3D>() -> std::size_t { return 3; }
+
+template <> struct field<PackedPoint2D> {
+  using type = int_t;
+};
+template <> struct field<PackedPoint3D> {
+  using type = int_t;
+};
+
+template <> struct constructor<PackedPoint2D> {
+  template <class InputIt>
+  auto operator()(InputIt first, InputIt last) const -> PackedPoint2D {
+    if (std::distance(first, last) != 2) {
+      throw std::invalid_argument(
+          "PackedPoint2D constructor requires exactly 2 elements");
+    }
+    const auto x = *first++;
+    const auto y = *first++;
+    return PackedPoint2D::of(x, y);
+  };
+};
+
+template <> struct constructor<PackedPoint3D> {
+  template <class InputIt>
+  auto operator()(InputIt first, InputIt last) const -> PackedPoint3D {
+    if (std::distance(first, last) != 3) {
+      throw std::invalid_argument(
+          "PackedPoint3D constructor requires exactly 3 elements");
+    }
+    const auto x = *first++;
+    const auto y = *first++;
+    const auto z = *first++;
+    return PackedPoint3D::of(x, y, z);
+  };
+};
+
+} // namespace lerw
+
+namespace std {
+
+template <> struct hash<lerw::PackedPoint2D> {
+  auto operator()(const lerw::PackedPoint2D &p) const -> std::size_t {
+    return std::hash<std::uint64_t>{}(p.bits);
+  }
+};
+
+template <> struct hash<lerw::PackedPoint3D> {
+  auto operator()(const lerw::PackedPoint3D &p) const -> std::size_t {
+    return std::hash<std::uint64_t>{}(p.bits);
+  }
+};
+
+} // namespace std
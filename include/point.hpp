@@ -2,7 +2,11 @@
 
 #include <array>
 #include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <stdexcept>
 #include <iterator>
+#include <limits>
 #include <unordered_set> // IWYU pragma: keep // std::hash
 
 #include "concepts.hpp" // IWYU pragma: keep // zero<T>()
@@ -12,46 +16,62 @@ namespace lerw {
 
 using int_t = int32_t;
 
+// The coordinate type is a parameter: 16 bit coordinates halve the memory
+// of walks and visited sets at small distances, 64 bit ones allow huge
+// distances. LERWComputer picks the narrowest that fits.
+
+// Whether walks stopped at distance give the same lengths with coordinates
+// of type T as with wider ones. The points inside the ball fit, and a step
+// out of it saturates (see saturating_add) to a point that is still
+// outside, as long as T holds more than twice the distance: a step of L1
+// length max(T) from inside ends at L1 norm max(T) - distance at least.
+template <std::signed_integral T>
+constexpr auto fits_coordinates(double distance) -> bool {
+  return 2 * distance + 1 < static_cast<double>(std::numeric_limits<T>::max());
+}
+
 // Rudimentary testing shows that this is as fast as a plain int
-struct Point1D {
-  int_t x;
+template <std::signed_integral T> struct BasicPoint1D {
+  T x;
 
-  constexpr auto operator+=(const Point1D &rhs) -> Point1D & {
-    x += rhs.x;
+  constexpr auto operator+=(const BasicPoint1D &rhs) -> BasicPoint1D & {
+    x = saturating_add(x, rhs.x);
     return *this;
   }
 
-  constexpr friend auto operator+(Point1D lhs, const Point1D &rhs) -> Point1D {
+  constexpr friend auto operator+(BasicPoint1D lhs,
+                                  const BasicPoint1D &rhs) -> BasicPoint1D {
     lhs += rhs;
     return lhs;
   }
 
-  constexpr auto operator==(const Point1D &) const -> bool = default;
+  constexpr auto operator==(const BasicPoint1D &) const -> bool = default;
 
-  consteval static auto Directions() -> std::array<Point1D, 2> {
-    return {Point1D{1}, {-1}};
+  consteval static auto Directions() -> std::array<BasicPoint1D, 2> {
+    return {BasicPoint1D{1}, {-1}};
   }
 };
 
-struct Point2D {
-  int_t x;
-  int_t y;
+template <std::signed_integral T> struct BasicPoint2D {
+  T x;
+  T y;
 
-  constexpr auto operator+=(const Point2D &rhs) -> Point2D & {
-    x += rhs.x;
-    y += rhs.y;
+  constexpr auto operator+=(const BasicPoint2D &rhs) -> BasicPoint2D & {
+    x = saturating_add(x, rhs.x);
+    y = saturating_add(y, rhs.y);
     return *this;
   }
 
-  constexpr friend auto operator+(Point2D lhs, const Point2D &rhs) -> Point2D {
+  constexpr friend auto operator+(BasicPoint2D lhs,
+                                  const BasicPoint2D &rhs) -> BasicPoint2D {
     lhs += rhs;
     return lhs;
   }
 
-  constexpr auto operator==(const Point2D &) const -> bool = default;
+  constexpr auto operator==(const BasicPoint2D &) const -> bool = default;
 
-  consteval static auto Directions() -> std::array<Point2D, 8> {
-    return {Point2D{
+  consteval static auto Directions() -> std::array<BasicPoint2D, 8> {
+    return {BasicPoint2D{
                 1,
                 0,
             },
@@ -70,96 +90,186 @@ struct Point2D {
   }
 };
 
-struct Point3D {
-  int_t x;
-  int_t y;
-  int_t z;
+template <std::signed_integral T> struct BasicPoint3D {
+  T x;
+  T y;
+  T z;
 
-  constexpr auto operator+=(const Point3D &rhs) -> Point3D & {
-    x += rhs.x;
-    y += rhs.y;
-    z += rhs.z;
+  constexpr auto operator+=(const BasicPoint3D &rhs) -> BasicPoint3D & {
+    x = saturating_add(x, rhs.x);
+    y = saturating_add(y, rhs.y);
+    z = saturating_add(z, rhs.z);
     return *this;
   }
 
-  constexpr friend auto operator+(Point3D lhs, const Point3D &rhs) -> Point3D {
+  constexpr friend auto operator+(BasicPoint3D lhs,
+                                  const BasicPoint3D &rhs) -> BasicPoint3D {
     lhs += rhs;
     return lhs;
   }
 
-  constexpr auto operator==(const Point3D &) const -> bool = default;
+  constexpr auto operator==(const BasicPoint3D &) const -> bool = default;
 
-  consteval static auto Directions() -> std::array<Point3D, 8> {
-    return {Point3D{1, 0, 0}, {-1, 0, 0}, {0, 1, 0},
-            {0, -1, 0},       {0, 0, 1},  {0, 0, -1}};
+  consteval static auto Directions() -> std::array<BasicPoint3D, 8> {
+    return {BasicPoint3D{1, 0, 0}, {-1, 0, 0}, {0, 1, 0},
+            {0, -1, 0},            {0, 0, 1},  {0, 0, -1}};
   }
 };
 
-template <Norm N> constexpr auto norm(Point1D p) -> double {
+using Point1D = BasicPoint1D<int_t>;
+using Point2D = BasicPoint2D<int_t>;
+using Point3D = BasicPoint3D<int_t>;
+
+template <Norm N, class T> constexpr auto norm(BasicPoint1D<T> p) -> double {
   return norm<N>(p.x);
 }
 
-template <Norm N> constexpr auto norm(Point2D p) -> double {
+template <Norm N, class T> constexpr auto norm(BasicPoint2D<T> p) -> double {
   return norm<N>(p.x, p.y);
 }
 
-template <Norm N> constexpr auto norm(Point3D p) -> double {
+template <Norm N, class T> constexpr auto norm(BasicPoint3D<T> p) -> double {
   return norm<N>(p.x, p.y, p.z);
 }
 
-template <> constexpr auto zero<Point1D>() -> Point1D { return {0}; }
-template <> constexpr auto zero<Point2D>() -> Point2D { return {0, 0}; }
-template <> constexpr auto zero<Point3D>() -> Point3D { return {0, 0, 0}; }
+template <class T>
+constexpr auto coordinates(BasicPoint1D<T> p) -> std::array<T, 1> {
+  return {p.x};
+}
+
+template <class T>
+constexpr auto coordinates(BasicPoint2D<T> p) -> std::array<T, 2> {
+  return {p.x, p.y};
+}
+
+template <class T>
+constexpr auto coordinates(BasicPoint3D<T> p) -> std::array<T, 3> {
+  return {p.x, p.y, p.z};
+}
 
-template <> constexpr auto dim<Point1D>() -> std::size_t { return 1; }
-template <> constexpr auto dim<Point2D>() -> std::size_t { return 2; }
-template <> constexpr auto dim<Point3D>() -> std::size_t { return 3; }
+// Explicit specializations for the supported coordinate types, like for
+// int in concepts.hpp: templates call zero<P>() and dim<P>() without
+// arguments, so a constrained overload declared here would not be found by
+// those included before this header.
+template <>
+constexpr auto
+zero<BasicPoint1D<std::int16_t>>() -> BasicPoint1D<std::int16_t> {
+  return {};
+}
+template <>
+constexpr auto
+zero<BasicPoint1D<std::int32_t>>() -> BasicPoint1D<std::int32_t> {
+  return {};
+}
+template <>
+constexpr auto
+zero<BasicPoint1D<std::int64_t>>() -> BasicPoint1D<std::int64_t> {
+  return {};
+}
+template <>
+constexpr auto
+zero<BasicPoint2D<std::int16_t>>() -> BasicPoint2D<std::int16_t> {
+  return {};
+}
+template <>
+constexpr auto
+zero<BasicPoint2D<std::int32_t>>() -> BasicPoint2D<std::int32_t> {
+  return {};
+}
+template <>
+constexpr auto
+zero<BasicPoint2D<std::int64_t>>() -> BasicPoint2D<std::int64_t> {
+  return {};
+}
+template <>
+constexpr auto
+zero<BasicPoint3D<std::int16_t>>() -> BasicPoint3D<std::int16_t> {
+  return {};
+}
+template <>
+constexpr auto
+zero<BasicPoint3D<std::int32_t>>() -> BasicPoint3D<std::int32_t> {
+  return {};
+}
+template <>
+constexpr auto
+zero<BasicPoint3D<std::int64_t>>() -> BasicPoint3D<std::int64_t> {
+  return {};
+}
+
+template <> constexpr auto dim<BasicPoint1D<std::int16_t>>() -> std::size_t {
+  return 1;
+}
+template <> constexpr auto dim<BasicPoint1D<std::int32_t>>() -> std::size_t {
+  return 1;
+}
+template <> constexpr auto dim<BasicPoint1D<std::int64_t>>() -> std::size_t {
+  return 1;
+}
+template <> constexpr auto dim<BasicPoint2D<std::int16_t>>() -> std::size_t {
+  return 2;
+}
+template <> constexpr auto dim<BasicPoint2D<std::int32_t>>() -> std::size_t {
+  return 2;
+}
+template <> constexpr auto dim<BasicPoint2D<std::int64_t>>() -> std::size_t {
+  return 2;
+}
+template <> constexpr auto dim<BasicPoint3D<std::int16_t>>() -> std::size_t {
+  return 3;
+}
+template <> constexpr auto dim<BasicPoint3D<std::int32_t>>() -> std::size_t {
+  return 3;
+}
+template <> constexpr auto dim<BasicPoint3D<std::int64_t>>() -> std::size_t {
+  return 3;
+}
 
-template <> struct field<Point1D> {
-  using type = int_t;
+template <class T> struct field<BasicPoint1D<T>> {
+  using type = T;
 };
-template <> struct field<Point2D> {
-  using type = int_t;
+template <class T> struct field<BasicPoint2D<T>> {
+  using type = T;
 };
-template <> struct field<Point3D> {
-  using type = int_t;
+template <class T> struct field<BasicPoint3D<T>> {
+  using type = T;
 };
 
-template <> struct constructor<Point1D> {
+template <class T> struct constructor<BasicPoint1D<T>> {
   template <class InputIt>
-  auto operator()(InputIt first, InputIt last) const -> Point1D {
+  auto operator()(InputIt first, InputIt last) const -> BasicPoint1D<T> {
     if (std::distance(first, last) != 1) {
       throw std::invalid_argument(
           "Point1D constructor requires exactly 1 elements");
     }
-    const auto x = *first++;
+    const auto x = static_cast<T>(*first++);
     return {x};
   };
 };
 
-template <> struct constructor<Point2D> {
+template <class T> struct constructor<BasicPoint2D<T>> {
   template <class InputIt>
-  auto operator()(InputIt first, InputIt last) const -> Point2D {
+  auto operator()(InputIt first, InputIt last) const -> BasicPoint2D<T> {
     if (std::distance(first, last) != 2) {
       throw std::invalid_argument(
           "Point2D constructor requires exactly 2 elements");
     }
-    const auto x = *first++;
-    const auto y = *first++;
+    const auto x = static_cast<T>(*first++);
+    const auto y = static_cast<T>(*first++);
     return {x, y};
   };
 };
 
-template <> struct constructor<Point3D> {
+template <class T> struct constructor<BasicPoint3D<T>> {
   template <class InputIt>
-  auto operator()(InputIt first, InputIt last) const -> Point3D {
+  auto operator()(InputIt first, InputIt last) const -> BasicPoint3D<T> {
     if (std::distance(first, last) != 3) {
       throw std::invalid_argument(
           "Point3D constructor requires exactly 3 elements");
     }
-    const auto x = *first++;
-    const auto y = *first++;
-    const auto z = *first++;
+    const auto x = static_cast<T>(*first++);
+    const auto y = static_cast<T>(*first++);
+    const auto z = static_cast<T>(*first++);
     return {x, y, z};
   };
 };
@@ -168,25 +278,29 @@ template <> struct constructor<Point3D> {
 
 namespace std {
 
-template <> struct hash<lerw::Point1D> {
-  constexpr auto operator()(const lerw::Point1D &p) const -> std::size_t {
-    using field_t = lerw::field<lerw::Point1D>::type;
-    return std::hash<field_t>{}(p.x);
+// on the promoted coordinates, so that shifting does not drop the bits of 16
+// bit coordinates
+template <class T> struct hash<lerw::BasicPoint1D<T>> {
+  constexpr auto operator()(const lerw::BasicPoint1D<T> &p) const
+      -> std::size_t {
+    return std::hash<decltype(+p.x)>{}(p.x);
   }
 };
 
-template <> struct hash<lerw::Point2D> {
-  constexpr auto operator()(const lerw::Point2D &p) const -> std::size_t {
-    using field_t = lerw::field<lerw::Point2D>::type;
-    return std::hash<field_t>{}(p.x) ^ std::hash<field_t>{}(p.y << 8);
+template <class T> struct hash<lerw::BasicPoint2D<T>> {
+  constexpr auto operator()(const lerw::BasicPoint2D<T> &p) const
+      -> std::size_t {
+    using wide = decltype(+p.x);
+    return std::hash<wide>{}(p.x) ^ std::hash<wide>{}(p.y << 8);
   }
 };
 
-template <> struct hash<lerw::Point3D> {
-  constexpr auto operator()(const lerw::Point3D &p) const -> std::size_t {
-    using field_t = lerw::field<lerw::Point3D>::type;
-    return std::hash<field_t>{}(p.x) ^ std::hash<field_t>{}(p.y << 16) ^
-           std::hash<field_t>{}(p.z << 8);
+template <class T> struct hash<lerw::BasicPoint3D<T>> {
+  constexpr auto operator()(const lerw::BasicPoint3D<T> &p) const
+      -> std::size_t {
+    using wide = decltype(+p.x);
+    return std::hash<wide>{}(p.x) ^ std::hash<wide>{}(p.y << 16) ^
+           std::hash<wide>{}(p.z << 8);
   }
 };
 } // namespace std
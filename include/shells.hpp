@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "concepts.hpp"
+#include "utils.hpp"
+
+namespace lerw {
+
+// The lattice points on the L1- and LINF-spheres of small radius, generated
+// at compile time. Most steps of a heavy-tailed walk are short, and for
+// them, a uniform point of the sphere is a single uniform index into the
+// table (all points of a sphere are equally likely, so an alias table over
+// them would just be a uniform index, too). The samplers of directions.hpp
+// only run for the radii above.
+// There are no tables for L2: its radii are real numbers.
+template <std::size_t d, Norm n>
+  requires(n == Norm::L1 || n == Norm::LINF)
+struct Shells {
+  using coordinates_t = std::array<std::int8_t, d>;
+
+  // the tables are at most 8 KiB per dimension and norm, so that they stay
+  // in the L1 cache next to the walk
+  static constexpr std::size_t max_points = 8192 / d;
+  static constexpr int max_radius = 32;
+
+  static constexpr auto length(const coordinates_t &x) -> int {
+    auto l = 0;
+    for (const auto c : x) {
+      const auto a = c < 0 ? -c : c;
+      l = n == Norm::L1 ? l + a : std::max(l, a);
+    }
+    return l;
+  }
+
+  // calls f(x) for every point x with norm(x) <= r, in lexicographic
+  // order: one coordinate after another, within what is left of r
+  template <class F>
+  static constexpr auto for_each_point(int r, F &&f) -> void {
+    auto x = coordinates_t{};
+    visit(x, 0, r, f);
+  }
+
+  template <class F>
+  static constexpr auto visit(coordinates_t &x, std::size_t i, int left,
+                              F &f) -> void {
+    if (i == d) {
+      f(x);
+      return;
+    }
+    for (auto c = -left; c <= left; ++c) {
+      x[i] = static_cast<std::int8_t>(c);
+      visit(x, i + 1, n == Norm::L1 ? left - (c < 0 ? -c : c) : left, f);
+    }
+  }
+
+  // number of points with 0 < norm <= r, without visiting them
+  static constexpr auto ball_size(int r) -> std::size_t {
+    const auto side = static_cast<std::size_t>(2 * r + 1);
+    if constexpr (n == Norm::LINF) {
+      auto count = std::size_t{1};
+      for (std::size_t i = 0; i < d; ++i) {
+        count *= side;
+      }
+      return count - 1;
+    } else {
+      // counts[k]: the points of norm k, one dimension after another
+      auto counts = std::vector<std::size_t>(side / 2 + 1);
+      counts[0] = 1;
+      for (std::size_t i = 0; i < d; ++i) {
+        for (auto k = counts.size() - 1; k > 0; --k) {
+          // the new coordinate is 0 or +-c
+          for (std::size_t c = 1; c <= k; ++c) {
+            counts[k] += 2 * counts[k - c];
+          }
+        }
+      }
+      return std::accumulate(counts.cbegin(), counts.cend(), std::size_t{0}) -
+             1;
+    }
+  }
+
+  // the largest radius (up to max_radius) whose ball fits into the table,
+  // 0 if not even r = 1 does (e.g. LINF in 8 dimensions)
+  static constexpr int radius = [] {
+    auto r = 0;
+    while (r < max_radius && ball_size(r + 1) <= max_points) {
+      ++r;
+    }
+    return r;
+  }();
+
+  // the points of norm r are points[offsets[r - 1]], ...,
+  // points[offsets[r] - 1]
+  static constexpr auto offsets = [] {
+    auto o = std::array<std::uint32_t, static_cast<std::size_t>(radius) + 1>{};
+    for_each_point(radius, [&o](const auto &x) {
+      ++o[static_cast<std::size_t>(length(x))];
+    });
+    o[0] = 0;
+    std::partial_sum(o.cbegin(), o.cend(), o.begin());
+    return o;
+  }();
+
+  static constexpr auto points = [] {
+    auto p = std::array<coordinates_t, offsets.back()>{};
+    auto next = offsets;
+    for_each_point(radius, [&p, &next](const auto &x) {
+      if (const auto l = static_cast<std::size_t>(length(x)); l > 0) {
+        p[next[l - 1]++] = x;
+      }
+    });
+    return p;
+  }();
+
+  // a uniform point of norm r, for 0 < r <= radius
+  template <point Point, std::uniform_random_bit_generator RNG>
+  static auto sample(std::size_t r, RNG &rng) -> Point {
+    const auto i = std::uniform_int_distribution<std::uint32_t>{
+        offsets[r - 1], offsets[r] - 1}(rng);
+    const auto &x = points[i];
+    return constructor<Point>{}(x.cbegin(), x.cend());
+  }
+};
+
+} // namespace lerw
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace lerw::simd {
+
+// Operations on all the lanes of an array of integers at once, for the
+// points of array_point.hpp. Vectors are GCC's vector extensions (which
+// clang understands as well): the compiler maps them to the registers of
+// the target (SSE, AVX2, AVX-512, NEON, or plain integers), so there are no
+// intrinsics here. Arrays are loaded and stored with __builtin_bit_cast,
+// which compiles to unaligned moves. No function takes or returns a
+// vector, whose ABI depends on the target.
+
+template <class T, std::size_t N>
+using vector [[gnu::vector_size(N * sizeof(T))]] = T;
+
+// as saturating_add in utils.hpp, lane by lane: the sum wraps around in
+// unsigned arithmetic, and where it overflowed (the sign of the sum differs
+// from the signs of both summands), it is replaced by max or min, depending
+// on the sign of y
+template <std::signed_integral T, std::size_t N>
+auto saturating_add(const std::array<T, N> &x, const std::array<T, N> &y)
+    -> std::array<T, N> {
+  using vector_t = vector<T, N>;
+  using unsigned_t = vector<std::make_unsigned_t<T>, N>;
+  const auto a = __builtin_bit_cast(vector_t, x);
+  const auto b = __builtin_bit_cast(vector_t, y);
+  const auto sum = __builtin_bit_cast(
+      vector_t, __builtin_bit_cast(unsigned_t, a) +
+                    __builtin_bit_cast(unsigned_t, b));
+  const auto overflow = ((a ^ sum) & (b ^ sum)) < 0;
+  // -1 or 0, flipped to min or max
+  constexpr auto sign_shift = static_cast<int>(8 * sizeof(T) - 1);
+  const auto saturated = (b >> sign_shift) ^ std::numeric_limits<T>::max();
+  return __builtin_bit_cast(std::array<T, N>, overflow ? saturated : sum);
+}
+
+// a random odd weight per 64 bit word (the first outputs of splitmix64)
+inline constexpr auto hash_weights = std::array<std::uint64_t, 8>{
+    0xe220a8397b1dcdaf, 0x6e789e6aa1b965f5, 0x06c45d188009454f,
+    0xf88bb8a8724c81ed, 0x1b39896a51a8749b, 0x53cb9f0c747ea2eb,
+    0x2c829abe1f4532e1, 0xc584133ac916ab3d};
+
+// The array as 64 bit words (several lanes each), weighted and summed up,
+// with the high bits folded into the low ones. Two arrays collide only if
+// the weighted sum of their difference is 0 (mod 2^64), which for random
+// weights and small differences does not happen. The products are
+// independent, unlike the steps of hash_combine. (Multiplying vectors of
+// 64 bit lanes and summing them up was slower.)
+template <std::integral T, std::size_t N>
+  requires(sizeof(T) * N % 8 == 0 && sizeof(T) * N / 8 <= hash_weights.size())
+auto hash(const std::array<T, N> &x) -> std::uint64_t {
+  using words_t = std::array<std::uint64_t, sizeof(T) * N / 8>;
+  const auto words = __builtin_bit_cast(words_t, x);
+  auto sum = std::uint64_t{0};
+  for (std::size_t i = 0; i < words.size(); ++i) {
+    sum += words[i] * hash_weights[i];
+  }
+  return sum ^ (sum >> 32);
+}
+
+} // namespace lerw::simd
@@ -1,28 +1,139 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <cstddef>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
+#include "ball.hpp"
 #include "concepts.hpp"
 #include "utils.hpp"
 
 namespace lerw {
 
+// true if every step of this length from p ends outside the ball of radius
+// distance, whatever its direction: |p + x| >= |x| - |p|. The L2 directions
+// are rounded to the lattice, which moves them by up to sqrt(d) / 2, and the
+// slack is twice that, for the rounding of the norms as well.
+template <Norm N, point Point>
+constexpr auto leaves_ball(double distance, const Point &p, double length)
+    -> bool {
+  // most steps are too short to tell, without the norm of p
+  if (length <= distance) {
+    return false;
+  }
+  const auto slack =
+      N == Norm::L2 ? std::sqrt(static_cast<double>(dim<Point>())) : 0.0;
+  return length > distance + norm<N>(p) + slack;
+}
+
+// a point outside the ball of radius distance (in any norm)
+template <point Point> auto outside_point(double distance) -> Point {
+  using coordinate_t = field<Point>::type;
+  auto x = std::array<coordinate_t, dim<Point>()>{};
+  x[0] = static_cast<coordinate_t>(std::floor(distance) + 1);
+  return constructor<Point>{}(x.cbegin(), x.cend());
+}
+
+// on_step counts the points, so it is stateful: use one per walk
 struct LengthStopper {
   size_t length;
+  size_t steps = 0;
 
   template <class P>
   constexpr auto operator()(const std::vector<P> &walk) const -> bool {
     return walk.size() > length;
   }
+
+  template <class P> constexpr auto on_step(const P &) -> bool {
+    return ++steps > length;
+  }
 };
 
 template <Norm N> struct DistanceStopper {
   double distance;
+  Ball<N> ball = Ball<N>{distance};
 
   template <point Point>
   constexpr auto operator()(const std::vector<Point> &walk) const -> bool {
-    return norm<N>(walk.back()) > distance;
+    return on_step(walk.back());
+  }
+
+  template <point Point> constexpr auto on_step(const Point &p) const -> bool {
+    return ball.outside(p);
+  }
+
+  // for LoopErasedRandomWalkGenerator::skip_exits
+  template <point Point>
+  constexpr auto leaves(const Point &p, double length) const -> bool {
+    return leaves_ball<N>(distance, p, length);
+  }
+
+  template <point Point> auto exit_point() const -> Point {
+    return outside_point<Point>(distance);
+  }
+};
+
+// Stops once the walk leaves the largest of several balls, recording the
+// length of the walk when it first leaves each of them. Since a walk
+// has to pass every smaller distance before reaching a larger one,
+// this measures all distances in a single walk.
+// Stateful: use one per walk.
+template <Norm N> struct MultiDistanceStopper {
+  std::vector<double> distances;
+  // lengths[i] is the length when the walk first left distances[i]
+  std::vector<std::size_t> lengths{};
+
+  explicit MultiDistanceStopper(std::vector<double> distances_)
+      : distances{std::move(distances_)} {
+    if (distances.empty() || not std::ranges::is_sorted(distances)) {
+      throw std::invalid_argument{
+          "Distances need to be non-empty and sorted ascendingly."};
+    }
+    lengths.reserve(distances.size());
+    balls.reserve(distances.size());
+    for (const auto d : distances) {
+      balls.emplace_back(d);
+    }
+  }
+
+  template <point Point>
+  constexpr auto operator()(const std::vector<Point> &walk) -> bool {
+    return record(walk.back(), walk.size());
+  }
+
+  // the lengths are the number of points seen, i.e. the exit times of a
+  // plain random walk
+  template <point Point> constexpr auto on_step(const Point &p) -> bool {
+    return record(p, ++steps);
+  }
+
+  // for LoopErasedRandomWalkGenerator::skip_exits: a step that leaves the
+  // largest ball leaves all of them
+  template <point Point>
+  constexpr auto leaves(const Point &p, double length) const -> bool {
+    return leaves_ball<N>(distances.back(), p, length);
+  }
+
+  template <point Point> auto exit_point() const -> Point {
+    return outside_point<Point>(distances.back());
+  }
+
+private:
+  std::vector<Ball<N>> balls{};
+  std::size_t steps = 0;
+
+  template <point Point>
+  constexpr auto record(const Point &p, std::size_t length) -> bool {
+    // a single step can leave several balls at once
+    while (lengths.size() < distances.size() &&
+           balls[lengths.size()].outside(p)) {
+      lengths.push_back(length);
+    }
+    return lengths.size() == distances.size();
   }
 };
 
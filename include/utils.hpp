@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cmath>
+#include <concepts>
+#include <limits>
 #include <stdexcept>
 #include <string>
 
@@ -41,16 +43,29 @@ inline auto parse_norm(const std::string &normStr) -> Norm {
   throw std::invalid_argument("Invalid norm type. Must be L1, L2, or LINF");
 }
 
+// in double, so that large integer coordinates do not overflow
 template <class... T> constexpr auto l1_norm(T... args) -> double {
-  return (std::abs(args) + ...);
+  return (std::abs(static_cast<double>(args)) + ...);
 }
 
 template <class... T> constexpr auto l2_norm(T... args) -> double {
-  return std::sqrt((square{}(args) + ...));
+  return std::sqrt((square{}(static_cast<double>(args)) + ...));
 }
 
 template <class... T> constexpr auto linfty_norm(T... args) -> double {
-  return std::max({std::abs(args)...});
+  return std::max({std::abs(static_cast<double>(args))...});
+}
+
+// x + y, clamped to the range of T instead of overflowing. Points far out
+// stay far out, so a huge jump cannot wrap around back into a ball.
+template <std::signed_integral T>
+constexpr auto saturating_add(T x, T y) -> T {
+  T sum;
+  if (__builtin_add_overflow(x, y, &sum)) [[unlikely]] {
+    return y > 0 ? std::numeric_limits<T>::max()
+                 : std::numeric_limits<T>::min();
+  }
+  return sum;
 }
 
 template <Norm N> struct norm_selector;
@@ -0,0 +1,357 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+
+#include "concepts.hpp"
+#include "hash_set.hpp"
+
+namespace lerw {
+
+// Backends for the visited points of a loop-erased walk. Most map a point to
+// its index in the walk: operator[] returns a reference to the index, which
+// is npos for points that were not visited yet. TileVisited, SetVisited and
+// LifoHashSet (in hash_set.hpp) are sets instead, with contains/insert/erase.
+// clear() forgets all points but keeps the memory, so a backend can be reused
+// for the next walk, shrink() gives the memory back. capacity() is the number
+// of entries it holds memory for.
+
+template <class Point, class Hash = std::hash<Point>> struct HashVisited {
+  using index_type = std::size_t;
+  static constexpr auto npos = std::numeric_limits<index_type>::max();
+
+  hash_map<Point, index_type, Hash> map{};
+
+  auto operator[](const Point &p) -> index_type & {
+    return map.try_emplace(p, npos).first->second;
+  }
+
+  auto prefetch(const Point &p) const -> void { prefetch_slot(map, p); }
+
+  auto clear() -> void { map.clear(); }
+
+  auto shrink() -> void { map = decltype(map){}; }
+
+  auto capacity() const -> std::size_t { return map.capacity(); }
+};
+
+// Memory from calloc is zeroed lazily by the OS, page by page, and
+// default-initializing (instead of value-initializing) the elements keeps it
+// that way. So a large array only costs for the pages that are used.
+template <class T> struct ZeroedAllocator {
+  using value_type = T;
+
+  ZeroedAllocator() = default;
+  template <class U> ZeroedAllocator(const ZeroedAllocator<U> &) {}
+
+  auto allocate(std::size_t n) -> T * {
+    if (auto *p = std::calloc(n, sizeof(T))) {
+      return static_cast<T *>(p);
+    }
+    throw std::bad_alloc{};
+  }
+
+  auto deallocate(T *p, std::size_t) -> void { std::free(p); }
+
+  template <class U> auto construct(U *p) -> void {
+    ::new (static_cast<void *>(p)) U;
+  }
+
+  template <class U, class... Args>
+  auto construct(U *p, Args &&...args) -> void {
+    ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+  }
+
+  friend auto operator==(const ZeroedAllocator &,
+                         const ZeroedAllocator &) -> bool = default;
+};
+
+// The points on the walk in a set with the interface of std::unordered_set,
+// e.g. hash_set or boost_hash_set
+template <class Set> struct SetVisited {
+  using Point = Set::key_type;
+
+  Set set{};
+
+  auto contains(const Point &p) const -> bool { return set.contains(p); }
+
+  // false if p was in the set already
+  auto insert(const Point &p) -> bool { return set.insert(p).second; }
+
+  auto erase(const Point &p) -> void { set.erase(p); }
+
+  auto prefetch(const Point &p) const -> void {
+    if constexpr (requires { prefetch_slot(set, p); }) {
+      prefetch_slot(set, p);
+    } else if constexpr (requires { set.prefetch(p); }) {
+      set.prefetch(p);
+    }
+  }
+
+  auto clear() -> void { set.clear(); }
+
+  auto shrink() -> void { set = Set{}; }
+
+  auto capacity() const -> std::size_t { return set.bucket_count(); }
+};
+
+// A dense array over the box [-radius, radius]^d, the few points outside
+// (the last point of a walk stopped at distance radius) go into a hash map.
+// Every cell is stamped with the walk that wrote it, so clear() does not
+// touch the array (except every 2^32-th time, when the stamp wraps).
+template <class Point> struct LatticeVisited {
+  using index_type = std::uint32_t;
+  static constexpr auto npos = std::numeric_limits<index_type>::max();
+
+  struct Cell {
+    std::uint32_t stamp;
+    index_type index;
+  };
+
+  std::int64_t radius;
+  std::int64_t width = 2 * radius + 1;
+  std::vector<Cell, ZeroedAllocator<Cell>> cells;
+  std::uint32_t stamp = 1;
+  hash_map<Point, index_type> outside{};
+
+  explicit LatticeVisited(std::int64_t radius_ = 0)
+      : radius{radius_}, cells(checked_size(radius_)) {}
+
+  // number of cells for a box of the given radius
+  static auto size(std::int64_t radius) -> double {
+    return std::pow(2.0 * static_cast<double>(radius) + 1.0,
+                    static_cast<double>(dim<Point>()));
+  }
+
+  // a walk inside the box has fewer points than there are cells, so the
+  // indices fit into index_type
+  static auto fits(std::int64_t radius) -> bool {
+    return radius >= 0 && size(radius) < static_cast<double>(npos);
+  }
+
+  auto operator[](const Point &p) -> index_type & {
+    const auto i = offset(p);
+    if (i == outside_box) [[unlikely]] {
+      return outside.try_emplace(p, npos).first->second;
+    }
+    auto &cell = cells[i];
+    if (cell.stamp != stamp) {
+      cell = {stamp, npos};
+    }
+    return cell.index;
+  }
+
+  auto prefetch(const Point &p) const -> void {
+    if (const auto i = offset(p); i != outside_box) {
+      __builtin_prefetch(&cells[i]);
+    }
+  }
+
+  auto clear() -> void {
+    if (++stamp == 0) {
+      std::fill(cells.begin(), cells.end(), Cell{0, npos});
+      stamp = 1;
+    }
+    outside.clear();
+  }
+
+  // the lattice has a fixed size
+  auto shrink() -> void { outside = decltype(outside){}; }
+
+  // the lattice itself has a fixed size
+  auto capacity() const -> std::size_t { return outside.capacity(); }
+
+private:
+  static constexpr auto outside_box = std::numeric_limits<std::size_t>::max();
+
+  static auto checked_size(std::int64_t radius) -> std::size_t {
+    if (not fits(radius)) {
+      throw std::invalid_argument{"Radius needs to be non-negative and the "
+                                  "lattice to have fewer than 2^32 cells."};
+    }
+    return static_cast<std::size_t>(size(radius));
+  }
+
+  auto offset(const Point &p) const -> std::size_t {
+    auto i = std::int64_t{0};
+    for (const auto x : coordinates(p)) {
+      // compared before shifting, which could overflow for 64 bit x
+      const auto wide = static_cast<std::int64_t>(x);
+      if (wide < -radius || wide > radius) {
+        return outside_box;
+      }
+      i = i * width + (wide + radius);
+    }
+    return static_cast<std::size_t>(i);
+  }
+};
+
+// A set (not a map) of points, for walks too large for the other backends:
+// the points are stored as bitmaps of tiles (16x16 in 2D, 8x8x8 in 3D),
+// which are kept in a hash map. This takes about 0.2 bytes per point of a
+// densely visited region instead of about 20, and neighbouring points share
+// a cache line. Since the set only knows whether a point is on the walk,
+// the generator erases loops by popping the walk back to that point.
+template <class Point> struct TileVisited {
+  static constexpr auto d = dim<Point>();
+  // tiles have side^d bits, 256 or 512 for d <= 3
+  static constexpr auto side = d == 1 ? 256 : d == 2 ? 16 : d == 3 ? 8 : 4;
+  static constexpr auto shift = std::countr_zero(static_cast<unsigned>(side));
+  static constexpr auto bits = [] {
+    auto n = std::size_t{1};
+    for (std::size_t i = 0; i < d; ++i) {
+      n *= static_cast<std::size_t>(side);
+    }
+    return n;
+  }();
+  using Tile = std::array<std::uint64_t, (bits + 63) / 64>;
+
+  // keyed by the coordinates of the tile, stored as a Point
+  hash_map<Point, Tile> tiles{};
+
+  auto contains(const Point &p) const -> bool {
+    const auto [key, bit] = locate(p);
+    const auto it = tiles.find(key);
+    return it != tiles.end() && (it->second[bit / 64] >> (bit % 64) & 1);
+  }
+
+  // false if p was in the set already
+  auto insert(const Point &p) -> bool {
+    const auto [key, bit] = locate(p);
+    auto &word = tiles[key][bit / 64];
+    const auto mask = std::uint64_t{1} << (bit % 64);
+    const auto inserted = not(word & mask);
+    word |= mask;
+    return inserted;
+  }
+
+  // empty tiles are kept, they are likely to be visited again
+  auto erase(const Point &p) -> void {
+    const auto [key, bit] = locate(p);
+    if (const auto it = tiles.find(key); it != tiles.end()) {
+      it->second[bit / 64] &= ~(std::uint64_t{1} << (bit % 64));
+    }
+  }
+
+  auto prefetch(const Point &p) const -> void {
+    prefetch_slot(tiles, locate(p).key);
+  }
+
+  auto clear() -> void { tiles.clear(); }
+
+  auto shrink() -> void { tiles = decltype(tiles){}; }
+
+  auto capacity() const -> std::size_t { return tiles.capacity(); }
+
+private:
+  struct Location {
+    Point key;
+    std::size_t bit;
+  };
+
+  static auto locate(const Point &p) -> Location {
+    const auto x = coordinates(p);
+    auto key = x;
+    auto bit = std::size_t{0};
+    for (std::size_t i = d; i-- > 0;) {
+      // arithmetic shift, so that negative coordinates round down
+      key[i] = x[i] >> shift;
+      bit = bit * static_cast<std::size_t>(side) +
+            static_cast<std::size_t>(x[i] & (side - 1));
+    }
+    return {constructor<Point>{}(key.cbegin(), key.cend()), bit};
+  }
+};
+
+enum class VisitedBackend {
+  automatic,
+  hash,
+  lattice,
+  tiles,
+  gtl_set,
+  boost_set,
+  lifo_set
+};
+
+inline auto parse_visited_backend(const std::string &s) -> VisitedBackend {
+  if (s == "auto")
+    return VisitedBackend::automatic;
+  if (s == "hash")
+    return VisitedBackend::hash;
+  if (s == "lattice")
+    return VisitedBackend::lattice;
+  if (s == "tiles")
+    return VisitedBackend::tiles;
+  if (s == "gtl_set")
+    return VisitedBackend::gtl_set;
+  if (s == "boost_set") {
+#ifdef LERW_HAS_BOOST_FLAT_SET
+    return VisitedBackend::boost_set;
+#else
+    throw std::invalid_argument("boost_set needs boost >= 1.81");
+#endif
+  }
+  if (s == "lifo_set")
+    return VisitedBackend::lifo_set;
+  throw std::invalid_argument("Invalid visited backend. Must be auto, hash, "
+                              "lattice, tiles, gtl_set, boost_set, or "
+                              "lifo_set");
+}
+
+// the physical memory that is free now, where the system tells (glibc), and
+// a fixed budget of 1 GiB otherwise. That is plenty: lattices are only used
+// as long as they fit into the cache anyway.
+inline auto available_memory() -> std::size_t {
+#if defined(_SC_AVPHYS_PAGES) && defined(_SC_PAGESIZE)
+  const auto pages = sysconf(_SC_AVPHYS_PAGES);
+  const auto page_size = sysconf(_SC_PAGESIZE);
+  if (pages > 0 && page_size > 0) {
+    return static_cast<std::size_t>(pages) *
+           static_cast<std::size_t>(page_size);
+  }
+#endif
+  return std::size_t{1} << 30;
+}
+
+// Up to 3 dimensions: the lattice if it takes at most 8 MiB (about the size
+// of a last level cache) and all threads' lattices at most half of the given
+// memory, tiles otherwise. From 4 dimensions on: the hash map. These cutoffs
+// are not tuned; benchmarks/visited.cpp compares the backends on real walks
+// (run `./benchmarks "[visited]"`).
+template <class Point>
+auto choose_visited_backend(double distance, std::size_t threads,
+                            std::size_t memory) -> VisitedBackend {
+  if (dim<Point>() > 3) {
+    return VisitedBackend::hash;
+  }
+  constexpr auto cache = 8.0 * (1 << 20);
+  const auto radius = static_cast<std::int64_t>(std::floor(distance));
+  if (LatticeVisited<Point>::fits(radius)) {
+    const auto bytes =
+        LatticeVisited<Point>::size(radius) *
+        static_cast<double>(sizeof(typename LatticeVisited<Point>::Cell));
+    if (bytes <= cache &&
+        bytes * static_cast<double>(threads) <=
+            0.5 * static_cast<double>(memory)) {
+      return VisitedBackend::lattice;
+    }
+  }
+  return VisitedBackend::tiles;
+}
+
+} // namespace lerw
@@ -38,47 +38,102 @@ def get_walk_lengths(
         file_path.unlink(missing_ok=True)
 
     if not file_path.exists():
-        cmd = [
-            Path.cwd() / CPP_EXECUTABLE,
-            "--dimension",
-            dimension,
-            "--distance",
-            distance,
-            "--number_of_walks",
-            number_of_walks,
-            "--alpha",
-            alpha,
-            "--norm",
-            norm.name,
-            "--output",
-            file_path,
-            "--seed",
-            seed,
-        ]
-
-        result = subprocess.run(
-            list(map(str, cmd)),
-            capture_output=True,
-            text=True,
-            check=False,
+        _run(
+            [
+                "--dimension",
+                dimension,
+                "--distance",
+                distance,
+                "--number_of_walks",
+                number_of_walks,
+                "--alpha",
+                alpha,
+                "--norm",
+                norm.name,
+                "--output",
+                file_path,
+                "--seed",
+                seed,
+            ]
         )
 
-        # Check for any output, which indicates an error
-        if result.stdout or result.stderr or result.returncode != 0:
-            print(
-                f"Failed to call C++:\n{result.stderr}\n\n{result.stdout}",
-                file=sys.stderr,
-            )
-            raise subprocess.CalledProcessError(
-                returncode=result.returncode or 1,
-                cmd=cmd,
-                output=result.stdout,
-                stderr=result.stderr,
-            )
-
     return np.genfromtxt(file_path, dtype=np.int64, comments="#", delimiter="\n")
 
 
+def get_walk_lengths_by_distance(
+    dimension: int,
+    distances: list[float],
+    number_of_walks: int,
+    alpha: float,
+    norm: Norm,
+    seed: int = 3,
+    recompute: bool = False,
+) -> npt.NDArray[np.int64]:
+    """Get the lengths of walks when they first leave each of the distances.
+
+    All distances are measured on the same walks, in a single call of the
+    C++ executable. Returns an array of shape (number_of_walks, len(distances)).
+    """
+    DATA_DIR.mkdir(exist_ok=True)
+
+    distances_arg = ",".join(map(str, distances))
+    filename = _format_filename(
+        dimension, distances_arg, number_of_walks, alpha, norm, seed
+    )
+    file_path = DATA_DIR / filename
+
+    if recompute:
+        file_path.unlink(missing_ok=True)
+
+    if not file_path.exists():
+        _run(
+            [
+                "--dimension",
+                dimension,
+                "--distances",
+                distances_arg,
+                "--number_of_walks",
+                number_of_walks,
+                "--alpha",
+                alpha,
+                "--norm",
+                norm.name,
+                "--output",
+                file_path,
+                "--seed",
+                seed,
+            ]
+        )
+
+    return np.genfromtxt(
+        file_path, dtype=np.int64, comments="#", delimiter=",", ndmin=2
+    )
+
+
+def _run(args: list) -> None:
+    cmd = [Path.cwd() / CPP_EXECUTABLE, *args]
+
+    result = subprocess.run(
+        list(map(str, cmd)),
+        capture_output=True,
+        text=True,
+        check=False,
+    )
+
+    # Check for any output, which indicates an error
+    if result.stdout or result.stderr or result.returncode != 0:
+        print(
+            f"Failed to call C++:\n{result.stderr}\n\n{result.stdout}",
+            file=sys.stderr,
+        )
+        raise subprocess.CalledProcessError(
+            returncode=result.returncode or 1,
+            cmd=cmd,
+            output=result.stdout,
+            stderr=result.stderr,
+        )
+
+
 def _format_filename(
     dimension: int,
     distance: float,
@@ -105,7 +160,15 @@ def test():
     walks = get_walk_lengths(**args)
     assert file.exists()
     assert len(walks) == 10
-    assert walks[0] == 51
+    assert walks[0] == 108
+
+    # the last distance is the same walk as above
+    args.pop("distance")
+    walks_by_distance = get_walk_lengths_by_distance(
+        distances=[100, 1000, 5000], recompute=True, **args
+    )
+    assert walks_by_distance.shape == (10, 3)
+    assert (walks_by_distance[:, -1] == walks).all()
     print("all good")
 
 
@@ -6,7 +6,7 @@ from typing import List, Dict, Union
 from numpy.typing import NDArray
 from itertools import product
 
-from interface import Norm, get_walk_lengths
+from interface import Norm, get_walk_lengths_by_distance
 
 
 def estimate_exponent_with_errors(
@@ -89,9 +89,9 @@ def analyze_results(
     alpha: float,
     trials: int,
 ) -> Dict[str, Union[float, NDArray[np.float64]]]:
-    avg_lengths = [
-        np.mean(get_walk_lengths(dim, R, trials, alpha, norm)) for R in R_values
-    ]
+    # all R are measured on the same walks, in a single run of the binary
+    lengths = get_walk_lengths_by_distance(dim, R_values, trials, alpha, norm)
+    avg_lengths = list(np.mean(lengths, axis=0))
 
     # Perform analysis
     results = estimate_exponent_with_errors(R_values, avg_lengths)
@@ -0,0 +1,45 @@
+#include <cstddef>
+#include <vector>
+
+#include "kernels.hpp"
+#include "lerw.hpp"
+
+// compiled once per instruction set and dimension, with LERW_KERNEL_ISA set
+// to the name of the Isa (e.g. x86_64_v3), LERW_KERNEL_DIMENSION to the
+// dimension, and the compiler flags for the instruction set
+#if not defined(LERW_KERNEL_ISA) || not defined(LERW_KERNEL_DIMENSION)
+#error "LERW_KERNEL_ISA or LERW_KERNEL_DIMENSION is not set"
+#endif
+
+namespace lerw {
+
+template <Isa isa, std::size_t dim, Norm norm>
+auto lengths(const LERWComputer &computer) -> Lengths {
+  return computer.compute<dim, norm>();
+}
+
+template <Isa isa, std::size_t dim, Norm norm>
+auto multi_lengths(const LERWComputer &computer,
+                   const std::vector<double> &distances) -> MultiLengths {
+  return computer.compute<dim, norm>(distances);
+}
+
+constexpr auto kernel_isa = Isa::LERW_KERNEL_ISA;
+constexpr auto kernel_dim = std::size_t{LERW_KERNEL_DIMENSION};
+static_assert(kernel_dim >= 1 && kernel_dim <= max_dimension);
+
+template auto lengths<kernel_isa, kernel_dim, Norm::L1>(const LERWComputer &)
+    -> Lengths;
+template auto lengths<kernel_isa, kernel_dim, Norm::L2>(const LERWComputer &)
+    -> Lengths;
+template auto lengths<kernel_isa, kernel_dim, Norm::LINF>(const LERWComputer &)
+    -> Lengths;
+
+template auto multi_lengths<kernel_isa, kernel_dim, Norm::L1>(
+    const LERWComputer &, const std::vector<double> &) -> MultiLengths;
+template auto multi_lengths<kernel_isa, kernel_dim, Norm::L2>(
+    const LERWComputer &, const std::vector<double> &) -> MultiLengths;
+template auto multi_lengths<kernel_isa, kernel_dim, Norm::LINF>(
+    const LERWComputer &, const std::vector<double> &) -> MultiLengths;
+
+} // namespace lerw
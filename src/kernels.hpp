@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utils.hpp"
+
+// The instances of LERWComputer::compute that main can run, one per
+// instruction set, dimension and norm. They are instantiated in
+// src/kernel.cpp, which is compiled once per instruction set and dimension
+// (see CMakeLists.txt), so that they build in parallel and no compiler run
+// has to hold all of them. The instruction set is picked at startup, so
+// that one binary runs on any x86-64 machine, at the speed of its vector
+// units.
+
+#ifndef LERW_MAX_DIMENSION
+#define LERW_MAX_DIMENSION 8
+#endif
+
+namespace lerw {
+
+struct LERWComputer;
+
+// the x86-64 microarchitecture levels: v2 has SSE4.2, v3 AVX2 and FMA, v4
+// AVX-512. generic is whatever the compiler targets by default, e.g. on
+// other architectures.
+enum class Isa { generic, x86_64_v2, x86_64_v3, x86_64_v4 };
+
+inline auto isa_to_string(Isa isa) -> std::string {
+  switch (isa) {
+  case Isa::generic:
+    return "generic";
+  case Isa::x86_64_v2:
+    return "x86-64-v2";
+  case Isa::x86_64_v3:
+    return "x86-64-v3";
+  case Isa::x86_64_v4:
+    return "x86-64-v4";
+  default:
+    throw std::invalid_argument("Invalid isa value");
+  }
+}
+
+inline auto parse_isa(const std::string &isaStr) -> Isa {
+  for (const auto isa :
+       {Isa::generic, Isa::x86_64_v2, Isa::x86_64_v3, Isa::x86_64_v4}) {
+    if (isaStr == isa_to_string(isa)) {
+      return isa;
+    }
+  }
+  throw std::invalid_argument("Invalid isa. Must be generic, x86-64-v2, "
+                              "x86-64-v3, or x86-64-v4");
+}
+
+// whether this machine runs code compiled for isa
+inline auto supported(Isa isa) -> bool {
+  if (isa == Isa::generic) {
+    return true;
+  }
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  switch (isa) {
+  case Isa::x86_64_v2:
+    return __builtin_cpu_supports("x86-64-v2");
+  case Isa::x86_64_v3:
+    return __builtin_cpu_supports("x86-64-v3");
+  case Isa::x86_64_v4:
+    return __builtin_cpu_supports("x86-64-v4");
+  default:
+    break;
+  }
+#endif
+  return false;
+}
+
+// the instruction sets compiled, from the oldest to the newest. CMake
+// defines LERW_ISA_<isa> for each of them; without any, there is only
+// generic.
+inline constexpr auto isas = std::array{
+#if defined(LERW_ISA_generic) ||                                               \
+    not(defined(LERW_ISA_x86_64_v2) || defined(LERW_ISA_x86_64_v3) ||          \
+        defined(LERW_ISA_x86_64_v4))
+    Isa::generic,
+#endif
+#ifdef LERW_ISA_x86_64_v2
+    Isa::x86_64_v2,
+#endif
+#ifdef LERW_ISA_x86_64_v3
+    Isa::x86_64_v3,
+#endif
+#ifdef LERW_ISA_x86_64_v4
+    Isa::x86_64_v4,
+#endif
+};
+
+using Lengths = std::vector<std::size_t>;
+// one row per walk, one column per distance
+using MultiLengths = std::vector<std::vector<std::size_t>>;
+
+template <Isa isa, std::size_t dim, Norm norm>
+auto lengths(const LERWComputer &computer) -> Lengths;
+
+template <Isa isa, std::size_t dim, Norm norm>
+auto multi_lengths(const LERWComputer &computer,
+                   const std::vector<double> &distances) -> MultiLengths;
+
+struct Kernel {
+  Isa isa;
+  std::size_t dimension;
+  Norm norm;
+  Lengths (*lengths)(const LERWComputer &);
+  MultiLengths (*multi_lengths)(const LERWComputer &,
+                                const std::vector<double> &);
+};
+
+constexpr auto max_dimension = std::size_t{LERW_MAX_DIMENSION};
+
+template <std::size_t... i>
+constexpr auto make_kernels(std::index_sequence<i...>) {
+  constexpr auto norms = std::array{Norm::L1, Norm::L2, Norm::LINF};
+  constexpr auto per_isa = 3 * max_dimension;
+  // i = per_isa * isa + 3 * (dimension - 1) + norm
+  return std::array{
+      Kernel{isas[i / per_isa], i % per_isa / 3 + 1, norms[i % 3],
+             &lengths<isas[i / per_isa], i % per_isa / 3 + 1, norms[i % 3]>,
+             &multi_lengths<isas[i / per_isa], i % per_isa / 3 + 1,
+                            norms[i % 3]>}...};
+}
+
+inline constexpr auto kernels = make_kernels(
+    std::make_index_sequence<isas.size() * 3 * max_dimension>{});
+
+// the newest instruction set compiled that this machine runs, or generic
+inline auto best_isa() -> Isa {
+  for (auto it = isas.crbegin(); it != isas.crend(); ++it) {
+    if (supported(*it)) {
+      return *it;
+    }
+  }
+  return Isa::generic;
+}
+
+// nullptr if there is none
+constexpr auto find_kernel(Isa isa, std::size_t dimension,
+                           Norm norm) -> const Kernel * {
+  for (const auto &kernel : kernels) {
+    if (kernel.isa == isa && kernel.dimension == dimension &&
+        kernel.norm == norm) {
+      return &kernel;
+    }
+  }
+  return nullptr;
+}
+
+} // namespace lerw
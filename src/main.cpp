@@ -6,18 +6,39 @@
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <optional>
 #include <print>
-#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
 
+#include "kernels.hpp"
 #include "lerw.hpp"
 #include "utils.hpp"
 
 using namespace lerw;
 namespace po = boost::program_options;
 
-// helper for switch
-constexpr auto switch_pair(std::size_t dimension, Norm norm) -> std::size_t {
-  return (dimension << 2) + static_cast<size_t>(norm);
+// parse a comma-separated list of distances, e.g. "100,200,400"
+auto parse_distances(const std::string &s) -> std::vector<double> {
+  auto distances = std::vector<double>{};
+  auto stream = std::istringstream{s};
+  for (std::string token; std::getline(stream, token, ',');) {
+    distances.push_back(std::stod(token));
+  }
+  if (distances.empty() || not std::ranges::is_sorted(distances)) {
+    throw std::invalid_argument{
+        "distances must be a non-empty, ascending list"};
+  }
+  return distances;
+}
+
+template <class T> auto join(const std::vector<T> &values) -> std::string {
+  auto stream = std::ostringstream{};
+  for (auto it = values.cbegin(); it != values.cend(); ++it) {
+    stream << (it == values.cbegin() ? "" : ",") << *it;
+  }
+  return stream.str();
 }
 
 auto main(int argc, char *argv[]) -> int {
@@ -28,6 +49,15 @@ auto main(int argc, char *argv[]) -> int {
   double alpha = 0.5;     // shape parameter
   std::string output_path;
   std::size_t seed = 42; // default seed value
+  std::vector<double> distances{}; // measure several distances in one run
+  std::size_t interleave = 1;      // walks run round-robin per thread
+  auto visited = VisitedBackend::automatic;
+  bool packed = false;             // 2D/3D points packed into 64 bits
+  int coordinate_bits = 0;         // 0: the narrowest that fits
+  int jump_radius = 0;             // 0: no jump table
+  bool skip_exits = false;         // end walks by the length of the step
+  bool list_kernels = false;
+  std::optional<Isa> isa;          // of the kernels, the newest if not set
 
   po::options_description desc("Allowed options");
   desc.add_options()("help", "produce help message")(
@@ -41,10 +71,60 @@ auto main(int argc, char *argv[]) -> int {
                                   "number of walks")(
       "distance,R", po::value<double>(&distance)->default_value(distance),
       "distance from the origin when the walk is stopped")(
+      "distances",
+      po::value<std::string>()->notifier([&distances](const std::string &d) {
+        distances = parse_distances(d);
+      }),
+      "comma-separated ascending distances (e.g. 100,200,400); for every "
+      "walk, output the length when it first leaves each of them (overrides "
+      "distance)")(
       "alpha,a", po::value<double>(&alpha)->default_value(alpha),
       "shape parameter (must be > 0)")(
       "seed,s", po::value<std::size_t>(&seed)->default_value(seed),
       "random number generator seed")(
+      "interleave,K",
+      po::value<std::size_t>(&interleave)->default_value(interleave),
+      "number of walks run round-robin per thread, to hide cache misses for "
+      "large distances (does not change the results)")(
+      "visited",
+      po::value<std::string>()->default_value("auto")->notifier(
+          [&visited](const std::string &v) {
+            visited = parse_visited_backend(v);
+          }),
+      "how visited points are stored (auto, hash, lattice, tiles, gtl_set, "
+      "boost_set, or lifo_set); lattice is a dense array over the ball, tiles "
+      "a compact set for huge walks, auto picks one of them (does not change "
+      "the results)")(
+      "packed", po::bool_switch(&packed),
+      "store 2D and 3D points packed into 64 bits (3D only up to distance "
+      "2^20; does not change the results)")(
+      "coordinate-bits",
+      po::value<int>(&coordinate_bits)->default_value(coordinate_bits),
+      "bits per coordinate (16 from 3 dimensions on and only with the hash "
+      "visited set, 32, or 64); 0 picks the narrowest that does not change "
+      "the results and saves memory")(
+      "jump-radius",
+      po::value<int>(&jump_radius)->default_value(jump_radius),
+      "draw the L1 and LINF steps up to this length (at most 127) from one "
+      "table of all displacements, 0 for none; the walks are different ones "
+      "with the same distribution")(
+      "skip-exits", po::bool_switch(&skip_exits),
+      "end a walk without drawing the direction of its last step when its "
+      "length alone shows that it leaves; pays off for L2, whose directions "
+      "are the expensive ones (does not change the results)")(
+      "list-kernels", po::bool_switch(&list_kernels),
+      "list the instruction sets, dimensions and norms that can be run")(
+      "isa",
+      po::value<std::string>()->default_value("auto")->notifier(
+          [&isa](const std::string &i) {
+            if (i != "auto") {
+              isa = parse_isa(i);
+            }
+          }),
+      "instruction set of the kernels (generic, x86-64-v2, x86-64-v3, or "
+      "x86-64-v4, if compiled and supported by this machine); auto picks the "
+      "newest. This only fixes the code generated for the kernels, the "
+      "math library (exp, log, pow) still picks its own")(
       "output,o", po::value<std::string>(&output_path),
       "path to output file (if not specified, writes to stdout)");
 
@@ -62,11 +142,34 @@ auto main(int argc, char *argv[]) -> int {
     return 0;
   }
 
+  if (list_kernels) {
+    for (const auto &kernel : kernels) {
+      std::println(std::cout, "ISA={}{}, D={}, Norm={}",
+                   isa_to_string(kernel.isa),
+                   supported(kernel.isa) ? "" : " (not supported here)",
+                   kernel.dimension, norm_to_string(kernel.norm));
+    }
+    return 0;
+  }
+
   if (alpha <= 0) {
     std::cerr << "Error: alpha must be greater than 0\n";
     return 1;
   }
 
+  if (isa && not supported(*isa)) {
+    std::cerr << "Error: this machine does not support " << isa_to_string(*isa)
+              << "\n";
+    return 1;
+  }
+
+  const auto *kernel = find_kernel(isa.value_or(best_isa()), dimension, norm);
+  if (kernel == nullptr) {
+    std::cerr << "Error: unsupported isa/dimension/norm choice (see "
+                 "--list-kernels)\n";
+    return 1;
+  }
+
   std::ofstream output_file;
   std::ostream *out = &std::cout; // Default to cout
   if (vm.count("output")) {
@@ -78,52 +181,29 @@ auto main(int argc, char *argv[]) -> int {
     out = &output_file;
   }
 
-  auto seed_rng = std::mt19937{seed};
-  auto computer = LERWComputer{[&seed_rng] { return std::mt19937{seed_rng()}; },
-                               N, alpha, distance};
-
-  const auto lengths = [&] {
-    switch (switch_pair(dimension, norm)) {
-    case switch_pair(1, Norm::L1):
-      return computer.compute<1, Norm::L1>();
-    case switch_pair(2, Norm::L1):
-      return computer.compute<2, Norm::L1>();
-    case switch_pair(3, Norm::L1):
-      return computer.compute<3, Norm::L1>();
-    case switch_pair(4, Norm::L1):
-      return computer.compute<4, Norm::L1>();
-    case switch_pair(5, Norm::L1):
-      return computer.compute<5, Norm::L1>();
-    case switch_pair(1, Norm::L2):
-      return computer.compute<1, Norm::L2>();
-    case switch_pair(2, Norm::L2):
-      return computer.compute<2, Norm::L2>();
-    case switch_pair(3, Norm::L2):
-      return computer.compute<3, Norm::L2>();
-    case switch_pair(4, Norm::L2):
-      return computer.compute<4, Norm::L2>();
-    case switch_pair(5, Norm::L2):
-      return computer.compute<5, Norm::L2>();
-      // TODO: LINF with d=1 is broken
-    // case switch_pair(1, Norm::LINF):
-    //   return computer.compute<1, Norm::LINF>();
-    case switch_pair(2, Norm::LINF):
-      return computer.compute<2, Norm::LINF>();
-    case switch_pair(3, Norm::LINF):
-      return computer.compute<3, Norm::LINF>();
-    case switch_pair(4, Norm::LINF):
-      return computer.compute<4, Norm::LINF>();
-    case switch_pair(5, Norm::LINF):
-      return computer.compute<5, Norm::LINF>();
-    default:
-      throw std::invalid_argument("Unsupported dimension/norm choice");
+  auto computer = LERWComputer{
+      seed,    N,      alpha,           distance,    interleave,
+      visited, packed, coordinate_bits, jump_radius, skip_exits};
+
+  if (distances.empty()) {
+    const auto lengths = kernel->lengths(computer);
+
+    std::println(*out, "# D={}, R={}, N={}, α={}, Norm={}, seed={}", dimension,
+                 distance, N, alpha, norm_to_string(norm), seed);
+
+    for (auto l : lengths) {
+      std::println(*out, "{}", l);
     }
-  }();
+    return 0;
+  }
+
+  const auto lengths = kernel->multi_lengths(computer, distances);
 
   std::println(*out, "# D={}, R={}, N={}, α={}, Norm={}, seed={}", dimension,
-               distance, N, alpha, norm_to_string(norm), seed);
+               join(distances), N, alpha, norm_to_string(norm), seed);
 
-  for (auto l : lengths) {
-    std::println(*out, "{}", l);
+  // one row per walk, one column per distance
+  for (const auto &row : lengths) {
+    std::println(*out, "{}", join(row));
   }
 }
@@ -0,0 +1,46 @@
+#include <array>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "alias.hpp"
+
+using namespace lerw;
+
+TEST_CASE("AliasTable") {
+  SECTION("frequencies") {
+    const auto weights = std::vector{1.0, 0.0, 5.0, 2.5, 0.5, 1.0};
+    const auto table = AliasTable{weights};
+    REQUIRE(table.size() == weights.size());
+
+    auto rng = std::mt19937{};
+    const std::size_t N = 1'000'000;
+    auto counts = std::vector<std::size_t>(weights.size());
+    for (std::size_t i = 0; i < N; ++i) {
+      counts[table(rng)]++;
+    }
+
+    REQUIRE(counts[1] == 0);
+    for (std::size_t i = 0; i < weights.size(); ++i) {
+      const auto expected = static_cast<double>(N) * weights[i] / 10.0;
+      CHECK(std::abs(static_cast<double>(counts[i]) - expected) <
+            5 * std::sqrt(expected) + 1);
+    }
+  }
+
+  SECTION("single outcome") {
+    const auto table = AliasTable{std::array{3.0}};
+    auto rng = std::mt19937{};
+    for (int i = 0; i < 100; ++i) {
+      REQUIRE(table(rng) == 0);
+    }
+  }
+
+  SECTION("invalid weights") {
+    REQUIRE_THROWS_AS(AliasTable{std::vector<double>{}}, std::invalid_argument);
+    REQUIRE_THROWS_AS(AliasTable(std::array{0.0, 0.0}), std::invalid_argument);
+    REQUIRE_THROWS_AS(AliasTable(std::array{1.0, -1.0}), std::invalid_argument);
+  }
+}
@@ -0,0 +1,75 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <limits>
+
+#include "array_point.hpp"
+#include "ball.hpp"
+#include "point.hpp"
+#include "utils.hpp"
+
+using namespace lerw;
+
+template <Norm N> void check_same_as_norm(double distance) {
+  const auto ball = Ball<N>{distance};
+  for (int_t x = -30; x <= 30; ++x) {
+    for (int_t y = -30; y <= 30; ++y) {
+      const auto p = Point2D{x, y};
+      REQUIRE(ball.outside(p) == (norm<N>(p) > distance));
+    }
+  }
+}
+
+TEST_CASE("Ball agrees with the norms") {
+  for (const auto distance : {-1.0, 0.0, 0.5, 1.0, 5.0, 7.3, 20.0, 25.5}) {
+    check_same_as_norm<Norm::L1>(distance);
+    check_same_as_norm<Norm::L2>(distance);
+    check_same_as_norm<Norm::LINF>(distance);
+  }
+}
+
+TEST_CASE("Ball does not overflow") {
+  const auto max = std::numeric_limits<int_t>::max();
+  const auto min = std::numeric_limits<int_t>::min();
+
+  REQUIRE(Ball<Norm::L2>{1e9}.outside(Point3D{max, max, max}));
+  REQUIRE(Ball<Norm::L1>{1e9}.outside(Point3D{min, 0, min}));
+  REQUIRE(Ball<Norm::LINF>{1e9}.outside(Point3D{0, min, 0}));
+  // the sum of the squares does not fit into 64 bits
+  const auto far = ArrayPoint<5>{min, min, min, min, min};
+  REQUIRE(Ball<Norm::L2>{1e9}.outside(far));
+  REQUIRE_FALSE(Ball<Norm::L2>{1e30}.outside(far));
+
+  // nothing is outside a huge ball
+  REQUIRE_FALSE(Ball<Norm::LINF>{1e20}.outside(Point2D{max, min}));
+  REQUIRE_FALSE(Ball<Norm::L2>{1e20}.outside(Point2D{max, min}));
+}
+
+TEST_CASE("Ball is exact where the squares do not fit into a double") {
+  // 1e8^2 needs 54 bits, so 1e8^2 + 1 rounds back down in double
+  using Wide = ArrayPoint<2, std::int64_t>;
+  REQUIRE_FALSE(Ball<Norm::L2>{1e8}.outside(Wide{100'000'000, 0}));
+  REQUIRE(Ball<Norm::L2>{1e8}.outside(Wide{100'000'000, 1}));
+  REQUIRE(Ball<Norm::L2>{1e8}.threshold == 10'000'000'000'000'001);
+  // the square of 2^31 + 1/2 has a fractional part of 1/4
+  REQUIRE(Ball<Norm::L2>{0x1p31 + 0.5}.threshold ==
+          (1ull << 62) + (1ull << 31) + 1);
+  // likewise, 2^53 + 1 does not fit into a double
+  REQUIRE(Ball<Norm::L1>{0x1p53}.threshold == (1ull << 53) + 1);
+  REQUIRE(Ball<Norm::LINF>{0x1p53}.threshold == (1ull << 53) + 1);
+}
+
+TEST_CASE("Ball is exact where the squares do not fit into 64 bits") {
+  // for distances from 2^32 on, the threshold of L2 needs more than 64 bits
+  using Wide = ArrayPoint<2, std::int64_t>;
+  const auto ball = Ball<Norm::L2>{1e10};
+  REQUIRE(ball.outside(Wide{20'000'000'000, 0}));
+  REQUIRE(ball.outside(Wide{0, -10'000'000'001}));
+  REQUIRE_FALSE(ball.outside(Wide{10'000'000'000, 0}));
+  REQUIRE_FALSE(ball.outside(Wide{7'000'000'000, 7'000'000'000}));
+  // 2^64 - 1 fits into 64 bits, and is still inside
+  REQUIRE_FALSE(ball.outside(Wide{4'294'967'295, 4'294'967'295}));
+
+  const auto max = std::numeric_limits<std::int64_t>::max();
+  REQUIRE(ball.outside(ArrayPoint<8, std::int64_t>{max, max, max, max, max,
+                                                   max, max, max}));
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <algorithm>
+#include <boost/random/uniform_on_sphere.hpp>
+#include <cmath>
+#include <iterator>
+#include <random>
+#include <vector>
+
+// (the points, so that their dim() is declared before the template)
+#include "array_point.hpp"
+#include "concepts.hpp"
+#include "point.hpp"
+
+// The previous L2Direction, based on boost::random::uniform_on_sphere: the
+// reference for tests/directions.cpp and benchmarks/directions.cpp
+template <lerw::point Point> struct BoostL2Direction {
+  using result_type = Point;
+
+  boost::random::uniform_on_sphere<> direction{
+      static_cast<int>(lerw::dim<Point>())};
+
+  template <std::uniform_random_bit_generator RNG>
+  auto operator()(double r, RNG &rng) -> Point {
+    auto dir = direction(rng);
+    auto dir_int = std::vector<typename lerw::field<Point>::type>{};
+    std::transform(dir.begin(), dir.end(), std::back_inserter(dir_int),
+                   [r](auto x) { return std::round(r * x); });
+    return lerw::constructor<Point>{}(dir_int.cbegin(), dir_int.cend());
+  }
+};
@@ -2,13 +2,18 @@
 #include <array>
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/generators/catch_generators.hpp>
+#include <cmath>
 #include <limits>
 #include <random>
 #include <ranges>
+#include <set>
 #include <unordered_map>
+#include <unordered_set>
 
+#include "boost_direction.hpp"
 #include "array_point.hpp"
 #include "directions.hpp"
+#include "shells.hpp"
 #include "utils.hpp"
 
 using namespace lerw;
@@ -54,6 +59,16 @@ void require_length(int_t r, std::size_t N) {
       [r, &rng](auto) { return Direction{}(r, rng); });
 }
 
+template <direction Direction>
+void check_covers_sphere(Direction d, int_t r, std::size_t expected_points) {
+  auto rng = std::mt19937{};
+  auto points = std::unordered_set<typename Direction::result_type>{};
+  for (std::size_t i = 0; i < 100 * expected_points; ++i) {
+    points.insert(d(r, rng));
+  }
+  CHECK(points.size() == expected_points);
+}
+
 TEST_CASE("L1") {
   using D1 = L1Direction<ArrayPoint<1>>;
   using D2 = L1Direction<ArrayPoint<2>>;
@@ -70,9 +85,33 @@ TEST_CASE("L1") {
     check_uniform(L1Direction<ArrayPoint<4>>{}, 1, N);
   }
 
+  SECTION("nonzero weights") {
+    // the number of points on the sphere is 4r in 2D and 4r^2 + 2 in 3D,
+    // 2 * d of which have a single nonzero coordinate
+    for (int_t r = 1; r < 10; ++r) {
+      const auto w2 = D2::nonzero_weights(r);
+      CHECK(4 * (w2[0] + w2[1]) == 4 * r);
+      const auto w3 = D3::nonzero_weights(r);
+      CHECK(6 * (w3[0] + w3[1] + w3[2]) == 4 * r * r + 2);
+    }
+  }
+
+  SECTION("covers sphere") {
+    check_covers_sphere(D1{}, 5, 2);
+    check_covers_sphere(D2{}, 3, 12);
+    check_covers_sphere(D3{}, 1, 6);
+    check_covers_sphere(D3{}, 2, 18);
+    check_covers_sphere(L1Direction<ArrayPoint<4>>{}, 1, 8);
+    // the largest tabulated r, and the smallest sampled one
+    const auto r = D2::shells::radius;
+    check_covers_sphere(D2{}, r, 4 * static_cast<std::size_t>(r));
+    check_covers_sphere(D2{}, r + 1, 4 * static_cast<std::size_t>(r + 1));
+  }
+
   SECTION("max r") {
-    const int_t r =
-        GENERATE(1, 2, 5, 100); // , std::numeric_limits<int_t>::max());
+    const int_t r = GENERATE(1, 2, 5, D3::shells::radius,
+                             D3::shells::radius + 1, 100,
+                             std::numeric_limits<int_t>::max());
     require_length<D1, Norm::L1>(r, N);
     require_length<D2, Norm::L1>(r, N);
     require_length<D3, Norm::L1>(r, N);
@@ -80,8 +119,8 @@ TEST_CASE("L1") {
   }
 }
 
-// TODO: Broken for d=1, why?
 TEST_CASE("LINF") {
+  using D1 = LinfDirection<ArrayPoint<1>>;
   using D2 = LinfDirection<ArrayPoint<2>>;
   using D3 = LinfDirection<ArrayPoint<3>>;
   SECTION("A_k") {
@@ -97,15 +136,35 @@ TEST_CASE("LINF") {
   }
 
   SECTION("A_k sums") {
-    REQUIRE(D2::A_k_sums(2) == std::array{0.0, 12.0});
-    REQUIRE(D3::A_k_sums(1) == std::array{0.0, 6.0, 18.0});
+    REQUIRE(D1::A_k_sums(3) == std::array{2.0});
+    REQUIRE(D2::A_k_sums(2) == std::array{12.0, 16.0});
+    REQUIRE(D3::A_k_sums(1) == std::array{6.0, 18.0, 26.0});
+  }
+
+  SECTION("choose_k") {
+    // both for tabulated and not tabulated r
+    const int_t r = GENERATE(1, 3, D3::tabulated_radii - 1,
+                             D3::tabulated_radii, 1000);
+    auto rng = std::mt19937{};
+    const std::size_t N = 200'000;
+    auto counts = std::array<std::size_t, 4>{};
+    for (std::size_t i = 0; i < N; ++i) {
+      counts[D3::choose_k(r, rng)]++;
+    }
+    const auto sums = D3::A_k_sums(r);
+    REQUIRE(counts[0] == 0);
+    for (std::uint16_t k = 1; k <= 3; ++k) {
+      const auto expected = static_cast<double>(N) * D3::A_k(k, r) / sums[2];
+      CHECK(std::abs(static_cast<double>(counts[k]) - expected) <
+            5 * std::sqrt(expected) + 1);
+    }
   }
 
   const std::size_t N = 100'000;
 
   SECTION("uniform") {
-    // check_uniform(LinfDirection<ArrayPoint<1>>{}, 1, N);
-    // require_uniform(LinfDirection<ArrayPoint<1>>{}, 100, N);
+    check_uniform(D1{}, 1, N);
+    check_uniform(D1{}, 100, N);
     check_uniform(D2{}, 1, N);
     check_uniform(D2{}, 5, N);
     check_uniform(D3{}, 1, N);
@@ -113,11 +172,117 @@ TEST_CASE("LINF") {
     check_uniform(LinfDirection<ArrayPoint<4>>{}, 1, N);
   }
 
+  SECTION("covers sphere") {
+    // including the vertices
+    check_covers_sphere(D1{}, 5, 2);
+    check_covers_sphere(D2{}, 1, 8);
+    check_covers_sphere(D2{}, 3, 24);
+    check_covers_sphere(D3{}, 1, 26);
+    check_covers_sphere(LinfDirection<ArrayPoint<4>>{}, 1, 80);
+    // the largest tabulated r, and the smallest sampled one
+    const auto r = D2::shells::radius;
+    check_covers_sphere(D2{}, r, 8 * static_cast<std::size_t>(r));
+    check_covers_sphere(D2{}, r + 1, 8 * static_cast<std::size_t>(r + 1));
+  }
+
   SECTION("max r") {
-    const int_t r = GENERATE(1, 2, 5, 100, std::numeric_limits<int_t>::max());
-    // require_length<LinfDirection<ArrayPoint<1>>, Norm::LINF>(r, N);
+    const int_t r = GENERATE(1, 2, 5, D3::shells::radius,
+                             D3::shells::radius + 1, 100,
+                             std::numeric_limits<int_t>::max());
+    require_length<D1, Norm::LINF>(r, N);
     require_length<D2, Norm::LINF>(r, N);
     require_length<D3, Norm::LINF>(r, N);
     require_length<LinfDirection<ArrayPoint<4>>, Norm::LINF>(r, N);
   }
 }
+
+// the number of points on the sphere of radius r, which has
+// C(d, j) * 2^j * C(r - 1, j - 1) points with j nonzero coordinates in L1,
+// and is the difference of two cubes in LINF
+template <std::size_t d, Norm n> auto sphere_size(int r) -> std::size_t {
+  const auto binomial = [](int a, int b) {
+    auto c = 1.0;
+    for (int i = 1; i <= b; ++i) {
+      c = c * (a - b + i) / i;
+    }
+    return c;
+  };
+  auto size = 0.0;
+  if constexpr (n == Norm::L1) {
+    for (int j = 1; j <= static_cast<int>(d); ++j) {
+      size += binomial(static_cast<int>(d), j) * std::pow(2, j) *
+              binomial(r - 1, j - 1);
+    }
+  } else {
+    size = std::pow(2 * r + 1, d) - std::pow(2 * r - 1, d);
+  }
+  return static_cast<std::size_t>(std::round(size));
+}
+
+template <std::size_t d, Norm n> void check_shells() {
+  using S = Shells<d, n>;
+  REQUIRE(S::points.size() <= S::max_points);
+  CHECK(S::ball_size(S::radius) == S::points.size());
+  for (int r = 1; r <= S::radius; ++r) {
+    const auto first = S::points.cbegin() + S::offsets[r - 1];
+    const auto last = S::points.cbegin() + S::offsets[r];
+    CHECK(static_cast<std::size_t>(last - first) == sphere_size<d, n>(r));
+    CHECK(std::all_of(first, last, [r](auto x) { return S::length(x) == r; }));
+    CHECK(std::set(first, last).size() == sphere_size<d, n>(r));
+  }
+}
+
+TEST_CASE("Shells") {
+  check_shells<1, Norm::L1>();
+  check_shells<2, Norm::L1>();
+  check_shells<3, Norm::L1>();
+  check_shells<4, Norm::L1>();
+  check_shells<8, Norm::L1>();
+  check_shells<1, Norm::LINF>();
+  check_shells<2, Norm::LINF>();
+  check_shells<3, Norm::LINF>();
+  check_shells<4, Norm::LINF>();
+  check_shells<6, Norm::LINF>();
+
+  SECTION("radii") {
+    // the tables get smaller with the dimension, down to nothing
+    CHECK(Shells<2, Norm::L1>::radius == Shells<2, Norm::L1>::max_radius);
+    CHECK(Shells<3, Norm::L1>::radius > Shells<3, Norm::LINF>::radius);
+    CHECK(Shells<8, Norm::L1>::radius > 0);
+    CHECK(Shells<8, Norm::LINF>::radius == 0);
+    REQUIRE(Shells<8, Norm::LINF>::points.empty());
+  }
+}
+
+template <point Point> void check_same_as_boost(std::size_t N) {
+  auto rng = std::mt19937{};
+  auto boost_rng = std::mt19937{};
+  auto direction = L2Direction<Point>{};
+  auto boost_direction = BoostL2Direction<Point>{};
+  for (std::size_t i = 0; i < N; ++i) {
+    const auto r = 1.0 + static_cast<double>(i % 100) * 0.37;
+    REQUIRE(direction(r, rng) == boost_direction(r, boost_rng));
+  }
+}
+
+TEST_CASE("L2") {
+  const std::size_t N = 10'000;
+
+  SECTION("same as boost::random::uniform_on_sphere") {
+    check_same_as_boost<ArrayPoint<1>>(N);
+    check_same_as_boost<ArrayPoint<2>>(N);
+    check_same_as_boost<ArrayPoint<3>>(N);
+    check_same_as_boost<ArrayPoint<4>>(N);
+    check_same_as_boost<ArrayPoint<5>>(N);
+  }
+
+  SECTION("long jumps are clamped") {
+    auto direction = L2Direction<ArrayPoint<3>>{};
+    auto rng = std::mt19937{};
+    for (std::size_t i = 0; i < 100; ++i) {
+      const auto p = direction(1e12, rng);
+      // some coordinate is at the limit, none has wrapped around
+      CHECK(norm<Norm::LINF>(p) >= std::numeric_limits<int_t>::max());
+    }
+  }
+}
@@ -1,8 +1,13 @@
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <limits>
 #include <numeric>
 #include <random>
 #include <vector>
 
+#include <boost/math/distributions/pareto.hpp>
+
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/generators/catch_generators.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
@@ -47,3 +52,154 @@ TEST_CASE("Zipf") {
     REQUIRE_THAT(mean, WithinRel(mean_expected, 0.01));
   }
 }
+
+TEST_CASE("Zipf frequencies") {
+  const auto a = GENERATE(0.3, 1.0, 2.0);
+
+  auto rng = std::mt19937{};
+  auto zipf = lerw::Zipf<std::int64_t>{a};
+
+  const auto N = 1 << 18;
+  auto counts = std::vector<int>(5);
+  for (int i = 0; i < N; ++i) {
+    const auto k = zipf(rng);
+    REQUIRE(k >= 1);
+    if (k <= 4) {
+      ++counts[static_cast<std::size_t>(k)];
+    }
+  }
+  // P(k) = k^-(a + 1) / Z(a + 1)
+  for (int k = 1; k <= 4; ++k) {
+    const auto expected = std::pow(k, -(a + 1)) / std::riemann_zeta(a + 1);
+    REQUIRE_THAT(counts[static_cast<std::size_t>(k)] / double{N},
+                 WithinRel(expected, 0.03));
+  }
+}
+
+TEST_CASE("Zipf minimum") {
+  const auto a = GENERATE(0.3, 1.0, 2.0);
+  const std::int64_t m = 65;
+
+  auto rng = std::mt19937{};
+  auto zipf = lerw::Zipf<std::int64_t>{a, m};
+
+  const auto N = 1 << 20;
+  auto counts = std::vector<int>(4);
+  for (int i = 0; i < N; ++i) {
+    const auto k = zipf(rng);
+    REQUIRE(k >= m);
+    if (k < m + 4) {
+      ++counts[static_cast<std::size_t>(k - m)];
+    }
+  }
+  // P(k) = k^-(a + 1) / sum_{j >= m} j^-(a + 1)
+  auto tail = std::riemann_zeta(a + 1);
+  for (std::int64_t j = 1; j < m; ++j) {
+    tail -= std::pow(j, -(a + 1));
+  }
+  for (std::int64_t k = m; k < m + 4; ++k) {
+    const auto expected = std::pow(k, -(a + 1)) / tail;
+    REQUIRE_THAT(counts[static_cast<std::size_t>(k - m)] / double{N},
+                 WithinRel(expected, 0.05));
+  }
+}
+
+TEST_CASE("Zipf saturates") {
+  auto rng = std::mt19937{};
+  auto zipf = lerw::Zipf<std::int8_t>{0.1};
+
+  auto saturated = 0;
+  for (int i = 0; i < 1000; ++i) {
+    const auto k = zipf(rng);
+    REQUIRE(k >= 1);
+    saturated += k == std::numeric_limits<std::int8_t>::max();
+  }
+  // P(k >= 127) is about 127^-0.1 = 0.6
+  REQUIRE(saturated > 500);
+}
+
+TEST_CASE("Zipf fill") {
+  const auto a = GENERATE(1.5, 2.5);
+  const auto mean_expected = std::riemann_zeta(a) / std::riemann_zeta(a + 1);
+
+  auto rng = std::mt19937{};
+  auto zipf = lerw::Zipf{a};
+
+  // not a multiple of the block size
+  auto v = std::vector<decltype(zipf)::result_type>((1 << 16) + 7);
+  zipf.fill(v, rng);
+  REQUIRE(std::ranges::all_of(v, [](auto k) { return k >= 1; }));
+  const auto mean =
+      std::accumulate(v.begin(), v.end(), 0.0) / static_cast<double>(v.size());
+  REQUIRE_THAT(mean, WithinRel(mean_expected, 0.01));
+}
+
+TEST_CASE("vlog, vexp") {
+  SECTION("log") {
+    for (auto x = 1e-300; x < 1e300; x *= 1.37) {
+      REQUIRE_THAT(lerw::vlog(x), WithinRel(std::log(x), 1e-15));
+    }
+    REQUIRE(lerw::vlog(1.0) == 0.0);
+  }
+
+  SECTION("exp") {
+    for (auto x = -700.0; x < 709.7; x += 0.173) {
+      REQUIRE_THAT(lerw::vexp(x), WithinRel(std::exp(x), 1e-15));
+    }
+    REQUIRE(lerw::vexp(0.0) == 1.0);
+    REQUIRE(lerw::vexp(710.0) == std::numeric_limits<double>::infinity());
+  }
+}
+
+TEST_CASE("Pareto") {
+  const auto alpha = GENERATE(0.1, 0.5, 1.0, 2.0, 5.0);
+  const auto reference = boost::math::pareto_distribution<>{1.0, alpha};
+
+  SECTION("sampler matches boost") {
+    auto rng = std::mt19937{};
+    auto boost_rng = std::mt19937{};
+    auto pareto = lerw::Pareto{alpha};
+    auto uniform = std::uniform_real_distribution<>{};
+    for (int i = 0; i < 1000; ++i) {
+      const auto expected =
+          boost::math::quantile(reference, uniform(boost_rng));
+      REQUIRE_THAT(pareto(rng), WithinRel(expected, 1e-14));
+    }
+  }
+
+  SECTION("tail accuracy of the batched kernel") {
+    // u = 1 - 2^-k reaches deep into the tail, down to the largest double
+    // below 1
+    auto us = std::vector<double>{};
+    for (int k = 1; k <= 53; ++k) {
+      us.push_back(1.0 - std::ldexp(1.0, -k));
+    }
+    for (int i = 0; i < 100; ++i) {
+      us.push_back(i / 100.0);
+    }
+    auto xs = us;
+    lerw::Pareto{alpha}.quantiles(xs);
+    for (std::size_t i = 0; i < us.size(); ++i) {
+      REQUIRE_THAT(xs[i], WithinRel(boost::math::quantile(reference, us[i]),
+                                    1e-13));
+    }
+  }
+
+  SECTION("fill matches single draws") {
+    auto rng = std::mt19937{};
+    auto other_rng = std::mt19937{};
+    auto pareto = lerw::Pareto{alpha};
+    auto xs = std::vector<double>(1000);
+    pareto.fill(xs, rng);
+    for (const auto x : xs) {
+      REQUIRE_THAT(x, WithinRel(pareto(other_rng), 1e-13));
+    }
+  }
+}
+
+TEST_CASE("Pareto overflow") {
+  // (2^-53)^(-1/α) does not fit into a double for small α
+  auto xs = std::vector<double>{1.0 - std::ldexp(1.0, -53)};
+  lerw::Pareto{0.01}.quantiles(xs);
+  REQUIRE(xs[0] == std::numeric_limits<double>::infinity());
+}
@@ -1,5 +1,9 @@
+#include <algorithm>
+#include <array>
 #include <catch2/catch_test_macros.hpp>
+#include <cstdint>
 #include <random>
+#include <type_traits>
 #include <vector>
 
 #include "generator.hpp"
@@ -161,3 +165,352 @@ TEST_CASE("ConstructDifferentCombinations") {
                                                    L2Direction<Point3D>{},
                                                }};
 }
+
+TEST_CASE("LoopErasedRandomWalkGenerator with several distances") {
+  // the length at the first exit of a distance does not depend on whether
+  // the walk continues afterwards
+  const auto distances = std::vector<double>{5.0, 20.0, 50.0};
+  const auto stepper = LDStepper{Pareto{1.0}, L2Direction<Point2D>{}};
+
+  for (std::uint32_t seed = 0; seed < 20; ++seed) {
+    auto rng = std::mt19937{seed};
+    auto multi = LoopErasedRandomWalkGenerator{
+        MultiDistanceStopper<Norm::L2>{distances}, stepper};
+    const auto walk = multi(rng);
+    REQUIRE(multi.stopper.lengths.size() == distances.size());
+    REQUIRE(multi.stopper.lengths.back() == walk.size());
+
+    for (std::size_t i = 0; i < distances.size(); ++i) {
+      auto single_rng = std::mt19937{seed};
+      auto single = LoopErasedRandomWalkGenerator{
+          DistanceStopper<Norm::L2>{distances[i]}, stepper};
+      REQUIRE(single(single_rng).size() == multi.stopper.lengths[i]);
+    }
+  }
+}
+
+// Walks with 16, 32 and 64 bit coordinates agree, apart from the last
+// point, which may saturate. Returns the number of walks where it did.
+template <Norm N, template <class> class Direction>
+auto check_same_walks(double alpha, double distance) -> std::size_t {
+  REQUIRE(fits_coordinates<std::int16_t>(distance));
+  const auto walk = [alpha, distance]<class P>(std::uint32_t seed) {
+    using Length = std::conditional_t<N == Norm::L2, Pareto,
+                                      Zipf<typename field<P>::type>>;
+    auto rng = std::mt19937{seed};
+    auto generator = LoopErasedRandomWalkGenerator{
+        DistanceStopper<N>{distance}, LDStepper{Length{alpha}, Direction<P>{}}};
+    return generator(rng);
+  };
+
+  const auto wide = []<class P>(const P &p) {
+    const auto x = coordinates(p);
+    return std::array<std::int64_t, 3>{x[0], x[1], x[2]};
+  };
+
+  auto saturated = std::size_t{0};
+  for (std::uint32_t seed = 0; seed < 100; ++seed) {
+    const auto w16 = walk.template operator()<BasicPoint3D<std::int16_t>>(seed);
+    const auto w32 = walk.template operator()<Point3D>(seed);
+    const auto w64 = walk.template operator()<BasicPoint3D<std::int64_t>>(seed);
+    REQUIRE(w16.size() == w32.size());
+    REQUIRE(w64.size() == w32.size());
+    for (std::size_t i = 0; i + 1 < w32.size(); ++i) {
+      REQUIRE(wide(w16[i]) == wide(w32[i]));
+      REQUIRE(wide(w64[i]) == wide(w32[i]));
+    }
+    saturated += wide(w16.back()) != wide(w64.back());
+  }
+  return saturated;
+}
+
+TEST_CASE("Coordinate types that fit give the same walks") {
+  check_same_walks<Norm::L2, L2Direction>(1.0, 20);
+  check_same_walks<Norm::LINF, LinfDirection>(1.5, 30);
+  REQUIRE(check_same_walks<Norm::L1, L1Direction>(0.3, 30) > 0);
+  REQUIRE(check_same_walks<Norm::L2, L2Direction>(0.3, 30) > 0);
+}
+
+TEST_CASE("RandomWalkGenerator::end is the end of the walk") {
+  const auto make = [] {
+    return RandomWalkGenerator{MultiDistanceStopper<Norm::L2>{{10, 20, 40}},
+                               NearestNeighborStepper<Point2D>{}};
+  };
+
+  for (std::uint32_t seed = 0; seed < 20; ++seed) {
+    auto rng = std::mt19937{seed};
+    auto generator = make();
+    const auto walk = generator(rng);
+
+    auto end_rng = std::mt19937{seed};
+    auto end_generator = make();
+    const auto end = end_generator.end(end_rng);
+
+    REQUIRE(end.point == walk.back());
+    REQUIRE(end.length == walk.size());
+    REQUIRE(end_generator.stopper.lengths == generator.stopper.lengths);
+    REQUIRE(end_generator.stopper.lengths.back() == walk.size());
+  }
+}
+
+// chronological loop erasure of a full walk
+template <class Point>
+auto erase_loops(const std::vector<Point> &walk) -> std::vector<Point> {
+  auto erased = std::vector<Point>{};
+  for (const auto &p : walk) {
+    const auto loop = std::find(erased.begin(), erased.end(), p);
+    if (loop != erased.end()) {
+      erased.erase(loop + 1, erased.end());
+    } else {
+      erased.push_back(p);
+    }
+  }
+  return erased;
+}
+
+// MockStopper for any point type
+struct StepStopper {
+  size_t max_steps;
+  size_t step_count = 0;
+
+  template <class P> bool operator()(const std::vector<P> &) {
+    return ++step_count > max_steps;
+  }
+};
+
+TEST_CASE("LoopErasedRandomWalkGenerator erases the loops of the walk") {
+  const auto steps = 2000;
+  const auto stepper = NearestNeighborStepper<Point2D>{};
+
+  for (std::uint32_t seed = 0; seed < 20; ++seed) {
+    auto rng = std::mt19937{seed};
+    auto walk = RandomWalkGenerator{StepStopper{steps}, stepper}(rng);
+
+    auto lerw_rng = std::mt19937{seed};
+    auto lerw =
+        LoopErasedRandomWalkGenerator{StepStopper{steps}, stepper}(lerw_rng);
+
+    REQUIRE(lerw == erase_loops(walk));
+  }
+}
+
+TEST_CASE("Interleaved LoopErasedWalks equal the generator") {
+  const auto stepper = NearestNeighborStepper<Point2D>{};
+  using generator_t =
+      LoopErasedRandomWalkGenerator<DistanceStopper<Norm::L2>,
+                                    NearestNeighborStepper<Point2D>>;
+  using walk_t = LoopErasedWalk<generator_t, std::mt19937>;
+
+  // advance several walks round-robin, as compute_interleaved_observables
+  auto lanes = std::vector<walk_t>{};
+  for (std::uint32_t seed = 0; seed < 8; ++seed) {
+    lanes.push_back(
+        walk_t{generator_t{DistanceStopper<Norm::L2>{20.0}, stepper},
+               std::mt19937{seed}, generator_t::Workspace{}});
+  }
+  auto running = std::vector<bool>(lanes.size(), true);
+  while (std::ranges::any_of(running, [](bool r) { return r; })) {
+    for (std::size_t j = 0; j < lanes.size(); ++j) {
+      running[j] = running[j] && lanes[j].propose();
+    }
+    for (std::size_t j = 0; j < lanes.size(); ++j) {
+      if (running[j]) {
+        lanes[j].add();
+      }
+    }
+  }
+
+  for (std::uint32_t seed = 0; seed < 8; ++seed) {
+    auto rng = std::mt19937{seed};
+    auto generator = generator_t{DistanceStopper<Norm::L2>{20.0}, stepper};
+    REQUIRE(lanes[seed].walk() == generator(rng));
+  }
+}
+
+// with skip_exits, the walks are the same apart from their last point,
+// which is a stand-in for the exit point where the length of the step
+// showed that it leaves. Returns the number of walks where it did.
+template <Norm N, class Length, class Direction>
+auto check_skip_exits(double alpha, double distance) -> std::size_t {
+  const auto stepper = LDStepper{Length{alpha}, Direction{}};
+  using Point = Direction::result_type;
+  auto skipped = std::size_t{0};
+  for (std::uint32_t seed = 0; seed < 200; ++seed) {
+    auto rng = std::mt19937{seed};
+    auto generator =
+        LoopErasedRandomWalkGenerator{DistanceStopper<N>{distance}, stepper};
+    const auto walk = generator(rng);
+
+    auto skip_rng = std::mt19937{seed};
+    auto skip = LoopErasedRandomWalkGenerator{DistanceStopper<N>{distance},
+                                              stepper, true};
+    const auto skip_walk = skip(skip_rng);
+    REQUIRE(skip_walk.size() == walk.size());
+    REQUIRE(std::equal(walk.begin(), walk.end() - 1, skip_walk.begin()));
+    REQUIRE(skip.stopper(skip_walk));
+    if (not(skip_walk.back() == walk.back())) {
+      REQUIRE(skip_walk.back() ==
+              skip.stopper.template exit_point<Point>());
+      ++skipped;
+    }
+  }
+  return skipped;
+}
+
+TEST_CASE("LoopErasedRandomWalkGenerator with skip_exits") {
+  SECTION("same lengths") {
+    CHECK(check_skip_exits<Norm::L1, Zipf<>, L1Direction<Point2D>>(0.3, 20) >
+          0);
+    CHECK(check_skip_exits<Norm::L2, Pareto, L2Direction<Point2D>>(0.3, 20) >
+          0);
+    CHECK(check_skip_exits<Norm::LINF, Zipf<>, LinfDirection<Point3D>>(
+              0.5, 10) > 0);
+  }
+
+  SECTION("several distances") {
+    const auto distances = std::vector<double>{5.0, 20.0, 50.0};
+    const auto stepper = LDStepper{Zipf<>{0.5}, L1Direction<Point2D>{}};
+    for (std::uint32_t seed = 0; seed < 50; ++seed) {
+      auto rng = std::mt19937{seed};
+      auto multi = LoopErasedRandomWalkGenerator{
+          MultiDistanceStopper<Norm::L1>{distances}, stepper};
+      multi(rng);
+      auto skip_rng = std::mt19937{seed};
+      auto skip = LoopErasedRandomWalkGenerator{
+          MultiDistanceStopper<Norm::L1>{distances}, stepper, true};
+      skip(skip_rng);
+      REQUIRE(skip.stopper.lengths == multi.stopper.lengths);
+    }
+  }
+
+  SECTION("interleaved") {
+    using stepper_t = LDStepper<Pareto, L2Direction<Point2D>>;
+    using generator_t =
+        LoopErasedRandomWalkGenerator<DistanceStopper<Norm::L2>, stepper_t>;
+    const auto stepper = stepper_t{Pareto{0.5}, L2Direction<Point2D>{}};
+    for (std::uint32_t seed = 0; seed < 50; ++seed) {
+      auto walk = LoopErasedWalk<generator_t, std::mt19937>{
+          generator_t{DistanceStopper<Norm::L2>{30.0}, stepper, true},
+          std::mt19937{seed}, generator_t::Workspace{}};
+      while (walk.propose()) {
+        walk.add();
+      }
+      auto rng = std::mt19937{seed};
+      auto generator =
+          generator_t{DistanceStopper<Norm::L2>{30.0}, stepper, true};
+      REQUIRE(walk.walk() == generator(rng));
+    }
+  }
+}
+
+TEST_CASE("LoopErasedRandomWalkGenerator with a reused lattice") {
+  const auto stepper = LDStepper{Pareto{1.0}, L2Direction<Point2D>{}};
+  using generator_t =
+      LoopErasedRandomWalkGenerator<DistanceStopper<Norm::L2>,
+                                    std::remove_const_t<decltype(stepper)>,
+                                    LatticeVisited<Point2D>>;
+  auto workspace =
+      generator_t::Workspace{.visited = LatticeVisited<Point2D>{50}};
+
+  for (std::uint32_t seed = 0; seed < 20; ++seed) {
+    auto rng = std::mt19937{seed};
+    auto dense = generator_t{DistanceStopper<Norm::L2>{50.0}, stepper};
+    const auto walk = dense(rng, workspace);
+
+    auto hash_rng = std::mt19937{seed};
+    auto hash = LoopErasedRandomWalkGenerator{DistanceStopper<Norm::L2>{50.0},
+                                              stepper};
+    REQUIRE(walk == hash(hash_rng));
+  }
+}
+
+template <class Visited> void check_erases_loops() {
+  const auto steps = 2000;
+  const auto stepper = NearestNeighborStepper<Point2D>{};
+  using generator_t =
+      LoopErasedRandomWalkGenerator<StepStopper,
+                                    NearestNeighborStepper<Point2D>, Visited>;
+
+  for (std::uint32_t seed = 0; seed < 20; ++seed) {
+    auto rng = std::mt19937{seed};
+    auto walk = RandomWalkGenerator{StepStopper{steps}, stepper}(rng);
+
+    auto lerw_rng = std::mt19937{seed};
+    auto lerw = generator_t{StepStopper{steps}, stepper}(lerw_rng);
+
+    REQUIRE(lerw == erase_loops(walk));
+  }
+}
+
+TEST_CASE("LoopErasedRandomWalkGenerator with other visited sets") {
+  check_erases_loops<TileVisited<Point2D>>();
+  check_erases_loops<SetVisited<hash_set<Point2D>>>();
+  check_erases_loops<LifoHashSet<Point2D>>();
+}
+
+TEST_CASE("Workspace") {
+  auto workspace = Workspace<Point2D, HashVisited<Point2D>>{};
+
+  SECTION("keeps its memory") {
+    workspace.walk.resize(1000);
+    workspace.visited[Point2D{1, 1}] = 1;
+    workspace.clear();
+    REQUIRE(workspace.walk.empty());
+    REQUIRE(workspace.walk.capacity() >= 1000);
+    REQUIRE(workspace.visited.map.empty());
+    REQUIRE(workspace.visited.map.capacity() > 0);
+  }
+
+  SECTION("keeps the memory of a long first walk") {
+    workspace.walk.resize(1 << 20);
+    workspace.clear();
+    REQUIRE(workspace.walk.capacity() >= 1 << 20);
+    workspace.walk.resize(1 << 20);
+    workspace.clear();
+    REQUIRE(workspace.walk.capacity() >= 1 << 20);
+  }
+
+  SECTION("gives it back after an outlier") {
+    for (int i = 0; i < 100; ++i) {
+      workspace.walk.resize(100);
+      workspace.clear();
+    }
+    workspace.walk.resize(1 << 20);
+    workspace.visited[Point2D{1, 1}] = 1;
+    workspace.clear();
+    REQUIRE(workspace.walk.capacity() == 0);
+    REQUIRE(workspace.visited.map.capacity() == 0);
+  }
+
+  SECTION("and after a walk that leaves a huge map behind") {
+    for (int i = 0; i < 100; ++i) {
+      workspace.walk.resize(100);
+      workspace.visited[Point2D{i, 0}] = 1;
+      workspace.clear();
+    }
+    // the loops were erased, the map still has all their points
+    workspace.walk.resize(100);
+    for (int i = 0; i < 1 << 20; ++i) {
+      workspace.visited[Point2D{i, 1}] = 1;
+    }
+    workspace.clear();
+    REQUIRE(workspace.walk.capacity() == 0);
+    REQUIRE(workspace.visited.map.capacity() == 0);
+  }
+}
+
+TEST_CASE("L2 walks with 64 bit coordinates leave balls beyond 2^32") {
+  // their squared norms do not fit into 64 bits
+  using P = BasicPoint2D<std::int64_t>;
+  const auto distance = 1e10;
+  const auto stepper = LDStepper{Pareto{0.3}, L2Direction<P>{}};
+  for (const auto skip_exits : {false, true}) {
+    for (std::uint32_t seed = 0; seed < 20; ++seed) {
+      auto rng = std::mt19937{seed};
+      auto generator = LoopErasedRandomWalkGenerator{
+          DistanceStopper<Norm::L2>{distance}, stepper, skip_exits};
+      const auto walk = generator(rng);
+      REQUIRE(Ball<Norm::L2>{distance}.outside(walk.back()));
+    }
+  }
+}
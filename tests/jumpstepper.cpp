@@ -0,0 +1,103 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "array_point.hpp"
+#include "directions.hpp"
+#include "distributions.hpp"
+#include "jumpstepper.hpp"
+#include "ldstepper.hpp"
+#include "point.hpp"
+
+using namespace lerw;
+using Catch::Matchers::WithinRel;
+
+TEST_CASE("JumpTable") {
+  SECTION("displacements") {
+    // all points of the ball, without the origin
+    CHECK(JumpTable<Point2D>::zipf<Norm::L1>(1.0, 3).jumps.size() == 24);
+    CHECK(JumpTable<Point2D>::zipf<Norm::LINF>(1.0, 3).jumps.size() == 48);
+    CHECK(JumpTable<Point3D>::zipf<Norm::LINF>(1.0, 1).jumps.size() == 26);
+    // and the tail
+    CHECK(JumpTable<Point2D>::zipf<Norm::L1>(1.0, 3).alias.size() == 25);
+  }
+
+  SECTION("radius") {
+    using Table = JumpTable<ArrayPoint<4>>;
+    CHECK_THROWS_AS(Table::zipf<Norm::L1>(1.0, 0), std::invalid_argument);
+    CHECK_THROWS_AS(Table::zipf<Norm::L1>(1.0, 128), std::invalid_argument);
+    CHECK_THROWS_AS(Table::zipf<Norm::LINF>(1.0, 64), std::invalid_argument);
+  }
+}
+
+// the lengths of the steps from the origin follow Zipf, and the
+// displacements of a length are uniform
+template <Norm n> void check_jumps(double alpha, int radius) {
+  using Direction = std::conditional_t<n == Norm::L1, L1Direction<Point2D>,
+                                       LinfDirection<Point2D>>;
+  auto stepper = JumpStepper{
+      std::make_shared<const JumpTable<Point2D>>(
+          JumpTable<Point2D>::zipf<n>(alpha, radius)),
+      Zipf{alpha, radius + 1}, Direction{}};
+  auto rng = std::mt19937{};
+  const auto N = 1 << 20;
+  auto lengths = std::vector<int>(static_cast<std::size_t>(radius) + 2);
+  auto unit_steps = std::unordered_map<Point2D, int>{};
+  for (int i = 0; i < N; ++i) {
+    const auto x = stepper(Point2D{0, 0}, rng);
+    const auto k = static_cast<int>(norm<n>(x));
+    REQUIRE(k >= 1);
+    ++lengths[static_cast<std::size_t>(std::min(k, radius + 1))];
+    if (k == 1) {
+      ++unit_steps[x];
+    }
+  }
+
+  const auto zeta = std::riemann_zeta(alpha + 1);
+  auto tail = 1.0;
+  for (int k = 1; k <= radius; ++k) {
+    const auto expected = std::pow(k, -(alpha + 1)) / zeta;
+    CHECK_THAT(lengths[static_cast<std::size_t>(k)] / double{N},
+               WithinRel(expected, 0.05));
+    tail -= expected;
+  }
+  CHECK_THAT(lengths[static_cast<std::size_t>(radius) + 1] / double{N},
+             WithinRel(tail, 0.05));
+
+  const auto sphere = n == Norm::L1 ? 4u : 8u;
+  REQUIRE(unit_steps.size() == sphere);
+  for (const auto &[x, count] : unit_steps) {
+    CHECK_THAT(count / static_cast<double>(lengths[1]),
+               WithinRel(1.0 / sphere, 0.05));
+  }
+}
+
+TEST_CASE("JumpStepper", "[stepper]") {
+  SECTION("distribution") {
+    const auto alpha = GENERATE(0.5, 1.0, 2.0);
+    check_jumps<Norm::L1>(alpha, 4);
+    check_jumps<Norm::LINF>(alpha, 4);
+  }
+
+  SECTION("same as LDStepper without a table") {
+    auto rng = std::mt19937{};
+    auto ld_rng = std::mt19937{};
+    auto stepper = JumpStepper{nullptr, Zipf{1.0}, L1Direction<Point2D>{}};
+    auto ld_stepper = LDStepper{Zipf{1.0}, L1Direction<Point2D>{}};
+    auto p = Point2D{0, 0};
+    for (int i = 0; i < 1000; ++i) {
+      const auto next = stepper(p, rng);
+      REQUIRE(next == ld_stepper(p, ld_rng));
+      p = next;
+    }
+  }
+}
@@ -0,0 +1,115 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <vector>
+
+#include "array_point.hpp"
+#include "hash_set.hpp"
+#include "lattice_hash.hpp"
+#include "point.hpp"
+
+using namespace lerw;
+
+template <class Point> auto box(int_t radius) -> std::vector<Point> {
+  auto points = std::vector<Point>{};
+  auto x = std::array<int_t, dim<Point>()>{};
+  x.fill(-radius);
+  while (true) {
+    points.push_back(constructor<Point>{}(x.cbegin(), x.cend()));
+    std::size_t i = 0;
+    for (; i < x.size() && x[i] == radius; ++i) {
+      x[i] = -radius;
+    }
+    if (i == x.size()) {
+      return points;
+    }
+    ++x[i];
+  }
+}
+
+template <class Point, class F> auto count_distinct(F f, int_t radius) {
+  auto values = std::set<std::uint64_t>{};
+  for (const auto &p : box<Point>(radius)) {
+    values.insert(f(p));
+  }
+  return values.size();
+}
+
+TEST_CASE("pack and morton are injective on small boxes") {
+  const auto pack2 = [](Point2D p) { return pack(p); };
+  const auto pack3 = [](Point3D p) { return pack(p); };
+  const auto pack5 = [](ArrayPoint<5> p) { return pack(p); };
+  const auto morton2 = [](Point2D p) { return morton(p); };
+  const auto morton3 = [](Point3D p) { return morton(p); };
+  const auto morton5 = [](ArrayPoint<5> p) { return morton(p); };
+
+  REQUIRE(count_distinct<Point2D>(pack2, 50) == 101 * 101);
+  REQUIRE(count_distinct<Point3D>(pack3, 10) == 21 * 21 * 21);
+  REQUIRE(count_distinct<ArrayPoint<5>>(pack5, 3) == 7 * 7 * 7 * 7 * 7);
+  REQUIRE(count_distinct<Point2D>(morton2, 50) == 101 * 101);
+  REQUIRE(count_distinct<Point3D>(morton3, 10) == 21 * 21 * 21);
+  REQUIRE(count_distinct<ArrayPoint<5>>(morton5, 3) == 7 * 7 * 7 * 7 * 7);
+
+  // the std::hash of Point2D is not
+  const auto xor2 = [](Point2D p) { return std::hash<Point2D>{}(p); };
+  REQUIRE(count_distinct<Point2D>(xor2, 300) < 601 * 601);
+}
+
+TEST_CASE("morton keeps aligned blocks together") {
+  for (const auto x : {-2, 0, 6}) {
+    for (const auto y : {-4, 0, 2}) {
+      const auto first = morton(Point2D{x, y});
+      REQUIRE(morton(Point2D{x + 1, y}) == first + 2);
+      REQUIRE(morton(Point2D{x, y + 1}) == first + 1);
+      REQUIRE(morton(Point2D{x + 1, y + 1}) == first + 3);
+      REQUIRE(morton(Point3D{x, y, 0}) + 7 ==
+              morton(Point3D{x + 1, y + 1, 1}));
+    }
+  }
+  REQUIRE(morton(Point2D{-1, -1}) < morton(Point2D{0, 0}));
+  REQUIRE(morton(Point3D{-5, 0, 0}) < morton(Point3D{-4, 0, 0}));
+}
+
+template <class Hash> void check_set() {
+  auto set = LifoHashSet<Point2D, Hash>{};
+  for (const auto &p : box<Point2D>(20)) {
+    REQUIRE(set.insert(p));
+  }
+  for (const auto &p : box<Point2D>(21)) {
+    REQUIRE(set.contains(p) == (std::abs(p.x) <= 20 && std::abs(p.y) <= 20));
+  }
+  for (const auto &p : box<Point2D>(20)) {
+    set.erase(p);
+  }
+  REQUIRE(set.empty());
+}
+
+TEST_CASE("LifoHashSet with lattice hashes") {
+  check_set<PackedHash>();
+  check_set<MortonHash>();
+}
+
+TEST_CASE("hash_statistics") {
+  const auto points = box<Point2D>(300);
+  const auto packed = hash_statistics<PackedHash>(points);
+  const auto xor_shift = hash_statistics<std::hash<Point2D>>(points);
+
+  REQUIRE(packed.collision_rate == 0.0);
+  REQUIRE(xor_shift.collision_rate > 0.0);
+  REQUIRE(packed.mean_probe_length < 1.0);
+  REQUIRE(packed.max_probe_length < 64);
+
+  // one pair of colliding points out of four
+  struct FirstCoordinateHash {
+    auto operator()(const Point2D &p) const -> std::size_t {
+      return static_cast<std::size_t>(p.x);
+    }
+  };
+  const auto pair = hash_statistics<FirstCoordinateHash>(
+      std::vector<Point2D>{{0, 0}, {1, 0}, {1, 1}, {2, 0}});
+  REQUIRE(pair.collision_rate == 0.5);
+
+  const auto empty = hash_statistics<PackedHash>(std::vector<Point2D>{});
+  REQUIRE(empty.max_probe_length == 0);
+}
@@ -0,0 +1,110 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "directions.hpp"
+#include "distributions.hpp"
+#include "generator.hpp"
+#include "ldstepper.hpp"
+#include "packed_point.hpp"
+#include "point.hpp"
+#include "rng.hpp"
+#include "stopper.hpp"
+
+using namespace lerw;
+
+TEST_CASE("PackedPoint2D") {
+  const auto max = std::numeric_limits<int_t>::max();
+  const auto min = std::numeric_limits<int_t>::min();
+  auto rng = std::mt19937{};
+  auto coordinate = std::uniform_int_distribution<int_t>{-1000, 1000};
+
+  for (int i = 0; i < 1000; ++i) {
+    const auto a = Point2D{coordinate(rng), coordinate(rng)};
+    const auto b = Point2D{coordinate(rng), coordinate(rng)};
+    const auto pa = PackedPoint2D::of(a.x, a.y);
+    const auto pb = PackedPoint2D::of(b.x, b.y);
+    REQUIRE(coordinates(pa + pb) == coordinates(a + b));
+    REQUIRE((pa == pb) == (a == b));
+    REQUIRE(norm<Norm::L2>(pa) == norm<Norm::L2>(a));
+  }
+
+  REQUIRE(coordinates(PackedPoint2D::of(max, min)) ==
+          std::array<int_t, 2>{max, min});
+  // x does not carry into y
+  REQUIRE(coordinates(PackedPoint2D::of(-1, 5) + PackedPoint2D::of(1, 0)) ==
+          std::array<int_t, 2>{0, 5});
+  REQUIRE(coordinates(PackedPoint2D::of(max, min) + PackedPoint2D::of(1, -1)) ==
+          std::array<int_t, 2>{max, min});
+  REQUIRE(zero<PackedPoint2D>() == PackedPoint2D::of(0, 0));
+}
+
+TEST_CASE("PackedPoint3D") {
+  const auto limit = int_t{1} << 20;
+  auto rng = std::mt19937{};
+  auto coordinate = std::uniform_int_distribution<int_t>{-1000, 1000};
+
+  for (int i = 0; i < 1000; ++i) {
+    const auto a = Point3D{coordinate(rng), coordinate(rng), coordinate(rng)};
+    const auto b = Point3D{coordinate(rng), coordinate(rng), coordinate(rng)};
+    const auto pa = PackedPoint3D::of(a.x, a.y, a.z);
+    const auto pb = PackedPoint3D::of(b.x, b.y, b.z);
+    REQUIRE(coordinates(pa + pb) == coordinates(a + b));
+    REQUIRE((pa == pb) == (a == b));
+    REQUIRE(norm<Norm::LINF>(pa) == norm<Norm::LINF>(a));
+  }
+
+  const auto corner = PackedPoint3D::of(-limit, limit - 1, -1);
+  REQUIRE_FALSE(corner.is_escaped());
+  REQUIRE(coordinates(corner) == std::array<int_t, 3>{-limit, limit - 1, -1});
+
+  // leaving the range escapes, for good
+  const auto escaped = corner + PackedPoint3D::of(0, 1, 0);
+  REQUIRE(escaped.is_escaped());
+  REQUIRE(PackedPoint3D::of(0, 0, -limit - 1) == escaped);
+  REQUIRE(escaped + PackedPoint3D::of(0, -1, 0) == escaped);
+  REQUIRE(std::isinf(norm<Norm::L1>(escaped)));
+
+  REQUIRE(PackedPoint3D::fits(1000.0));
+  REQUIRE_FALSE(PackedPoint3D::fits(2e6));
+}
+
+// the same walks as with the unpacked points, also when steps escape. LINF,
+// since the L2 norm of Point3D overflows for coordinates above 2^15.
+template <class Point, class Packed>
+auto check_same_walks(double alpha, double distance) -> std::size_t {
+  const auto stepper = [alpha]<class P>() {
+    return LDStepper{Zipf<int_t>{alpha}, LinfDirection<P>{}};
+  };
+  auto generator =
+      LoopErasedRandomWalkGenerator{DistanceStopper<Norm::LINF>{distance},
+                                    stepper.template operator()<Point>()};
+  auto packed_generator =
+      LoopErasedRandomWalkGenerator{DistanceStopper<Norm::LINF>{distance},
+                                    stepper.template operator()<Packed>()};
+
+  auto escaped = std::size_t{0};
+  for (std::size_t i = 0; i < 100; ++i) {
+    auto rng = Philox4x32{0, i};
+    auto packed_rng = Philox4x32{0, i};
+    const auto walk = generator(rng);
+    const auto packed_walk = packed_generator(packed_rng);
+    REQUIRE(walk.size() == packed_walk.size());
+    // apart from the last point, which may have escaped
+    for (std::size_t j = 0; j + 1 < walk.size(); ++j) {
+      REQUIRE(coordinates(walk[j]) == coordinates(packed_walk[j]));
+    }
+    escaped += std::isinf(norm<Norm::LINF>(packed_walk.back()));
+  }
+  return escaped;
+}
+
+TEST_CASE("Packed points give the same walks") {
+  check_same_walks<Point2D, PackedPoint2D>(1.0, 200);
+  check_same_walks<Point3D, PackedPoint3D>(1.5, 30);
+  // some walks end with a step longer than 2^20
+  REQUIRE(check_same_walks<Point3D, PackedPoint3D>(0.3, 50) > 0);
+}
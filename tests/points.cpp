@@ -1,5 +1,9 @@
 #include <catch2/catch_test_macros.hpp>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <set>
+#include <vector>
 
 #include "array_point.hpp"
 #include "concepts.hpp"
@@ -61,6 +65,15 @@ template <point P> void check2D() {
   CHECK(norm<Norm::LINF>(P{-1, -2}) == 2);
   CHECK(norm<Norm::LINF>(P{-5, 3}) == 5);
 
+  // no overflow
+  using T = field<P>::type;
+  const auto max = std::numeric_limits<T>::max();
+  const auto min = std::numeric_limits<T>::min();
+  CHECK(P{max, 1} + P{1, 1} == P{max, 2});
+  CHECK(P{-1, min} + P{1, -2} == P{0, min});
+  CHECK(norm<Norm::L2>(P{max, max}) > 1.41 * max);
+  CHECK(norm<Norm::L1>(P{min, min}) == -2.0 * min);
+
   // Vector construction
   const auto v = std::vector<int>{1, 2};
   CHECK(constructor<P>{}(v.cbegin(), v.cend()) == P{1, 2});
@@ -96,6 +109,10 @@ template <point P> void check3D() {
   CHECK(norm<Norm::LINF>(P{-1, -2, -3}) == 3);
   CHECK(norm<Norm::LINF>(P{-5, 3, 4}) == 5);
 
+  const auto max = std::numeric_limits<typename field<P>::type>::max();
+  CHECK(P{max, max, 0} + P{max, 1, 1} == P{max, max, 1});
+  CHECK(norm<Norm::L2>(P{max, max, max}) > 1.73 * max);
+
   const auto v = std::vector<int>{1, 2, 3};
   CHECK(constructor<P>{}(v.cbegin(), v.cend()) == P{1, 2, 3});
 
@@ -156,3 +173,91 @@ TEST_CASE("Points") {
 
   check4D<ArrayPoint<4>>();
 }
+
+TEST_CASE("Points with other coordinate types") {
+  check1D<BasicPoint1D<std::int64_t>>();
+
+  check2D<BasicPoint2D<std::int16_t>>();
+  check2D<BasicPoint2D<std::int64_t>>();
+  check2D<ArrayPoint<2, std::int64_t>>();
+
+  check3D<BasicPoint3D<std::int16_t>>();
+  check3D<BasicPoint3D<std::int64_t>>();
+  check3D<ArrayPoint<3, std::int16_t>>();
+
+  check4D<ArrayPoint<4, std::int16_t>>();
+  check4D<ArrayPoint<4, std::int64_t>>();
+
+  static_assert(sizeof(BasicPoint3D<std::int16_t>) == 6);
+  static_assert(sizeof(ArrayPoint<4, std::int16_t>) == 8);
+
+  REQUIRE(fits_coordinates<std::int16_t>(16382));
+  REQUIRE_FALSE(fits_coordinates<std::int16_t>(16383));
+  REQUIRE(fits_coordinates<std::int32_t>(1e9));
+  REQUIRE_FALSE(fits_coordinates<std::int32_t>(2e9));
+}
+
+// the vector operations (in 4 and 8 dimensions) agree with the scalar ones
+template <std::size_t Dim, class T> void check_vectorized() {
+  using P = ArrayPoint<Dim, T>;
+  static_assert(P::vectorized);
+
+  constexpr auto max = std::numeric_limits<T>::max();
+  constexpr auto min = std::numeric_limits<T>::min();
+  auto x = std::vector<T>(Dim);
+  auto y = std::vector<T>(Dim);
+  for (std::size_t i = 0; i < Dim; ++i) {
+    const auto v = static_cast<int>(i) + 1;
+    x[i] = static_cast<T>(i % 2 == 0 ? v : -v);
+    y[i] = i % 3 == 0 ? max : i % 3 == 1 ? min : static_cast<T>(7);
+  }
+  const auto p = constructor<P>{}(x.cbegin(), x.cend());
+  const auto q = constructor<P>{}(y.cbegin(), y.cend());
+
+  const auto sum = coordinates(p + q);
+  for (std::size_t i = 0; i < Dim; ++i) {
+    CHECK(sum[i] == saturating_add(x[i], y[i]));
+  }
+  CHECK(coordinates(q + q)[0] == max);
+  CHECK(coordinates(q + q)[1] == min);
+  CHECK(p + zero<P>() == p);
+
+  // the points of {-1, 0, 1}^Dim have distinct hashes
+  auto hashes = std::set<std::size_t>{};
+  auto point = std::vector<T>(Dim, -1);
+  auto count = std::size_t{0};
+  while (true) {
+    hashes.insert(
+        std::hash<P>{}(constructor<P>{}(point.cbegin(), point.cend())));
+    ++count;
+    auto i = std::size_t{0};
+    while (i < Dim && point[i] == 1) {
+      point[i++] = -1;
+    }
+    if (i == Dim) {
+      break;
+    }
+    ++point[i];
+  }
+  CHECK(hashes.size() == count);
+}
+
+TEST_CASE("Vectorized ArrayPoints") {
+  check_vectorized<4, std::int16_t>();
+  check_vectorized<4, std::int32_t>();
+  check_vectorized<4, std::int64_t>();
+  check_vectorized<8, std::int16_t>();
+  check_vectorized<8, std::int32_t>();
+  check_vectorized<8, std::int64_t>();
+  static_assert(not ArrayPoint<5>::vectorized);
+  // too short or too long for the vector hash
+  static_assert(not ArrayPoint<4, std::int8_t>::vectorized);
+  static_assert(not ArrayPoint<16, std::int64_t>::vectorized);
+  const auto wide = ArrayPoint<16, std::int64_t>{};
+  CHECK(std::hash<ArrayPoint<16, std::int64_t>>{}(wide + wide) ==
+        std::hash<ArrayPoint<16, std::int64_t>>{}(wide));
+
+  // at compile time, the scalar code runs
+  static_assert(ArrayPoint<4>{1, 2, 3, 4} + ArrayPoint<4>{1, 1, 1, 1} ==
+                ArrayPoint<4>{2, 3, 4, 5});
+}
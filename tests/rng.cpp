@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <concepts>
+#include <random>
+#include <vector>
+
+#include "rng.hpp"
+
+using namespace lerw;
+
+static_assert(std::uniform_random_bit_generator<Philox4x32>);
+
+TEST_CASE("Philox4x32") {
+  SECTION("known answers") {
+    // from the Random123 distribution (kat_vectors)
+    using block = Philox4x32::block_type;
+    using key = Philox4x32::key_type;
+    REQUIRE(Philox4x32::block(block{0, 0, 0, 0}, key{0, 0}) ==
+            block{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+    REQUIRE(Philox4x32::block(
+                block{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                key{0xffffffff, 0xffffffff}) ==
+            block{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd});
+    REQUIRE(Philox4x32::block(
+                block{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                key{0xa4093822, 0x299f31d0}) ==
+            block{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1});
+  }
+
+  SECTION("reproducible") {
+    auto a = Philox4x32{42, 7};
+    auto b = Philox4x32{42, 7};
+    for (int i = 0; i < 100; ++i) {
+      REQUIRE(a() == b());
+    }
+  }
+
+  SECTION("streams differ") {
+    const auto draw = [](Philox4x32 rng) {
+      auto v = std::vector<Philox4x32::result_type>(16);
+      std::generate(v.begin(), v.end(), rng);
+      return v;
+    };
+    REQUIRE(draw(Philox4x32{42, 0}) != draw(Philox4x32{42, 1}));
+    REQUIRE(draw(Philox4x32{42, 0}) != draw(Philox4x32{43, 0}));
+  }
+
+  SECTION("usable with std distributions") {
+    auto rng = Philox4x32{1, 2};
+    auto dist = std::uniform_real_distribution<>{};
+    const auto N = 1 << 16;
+    auto sum = 0.0;
+    for (int i = 0; i < N; ++i) {
+      const auto u = dist(rng);
+      REQUIRE(u >= 0.0);
+      REQUIRE(u < 1.0);
+      sum += u;
+    }
+    REQUIRE(std::abs(sum / N - 0.5) < 0.01);
+  }
+}
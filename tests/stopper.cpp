@@ -104,3 +104,88 @@ TEST_CASE("DistanceStopper tests for different norms") {
     }
   }
 }
+
+TEST_CASE("MultiDistanceStopper") {
+  SECTION("records the length at the first exit of every distance") {
+    MultiDistanceStopper<Norm::L1> stopper{{1.0, 2.0, 4.0}};
+    std::vector<Point2D> walk{{0, 0}};
+    REQUIRE_FALSE(stopper(walk));
+    walk.push_back({1, 1});
+    REQUIRE_FALSE(stopper(walk));
+    REQUIRE(stopper.lengths == std::vector<std::size_t>{2});
+    // back inside does not change anything
+    walk.back() = {0, 1};
+    REQUIRE_FALSE(stopper(walk));
+    // leaving the two outer balls at once
+    walk.push_back({5, 0});
+    REQUIRE(stopper(walk));
+    REQUIRE(stopper.lengths == std::vector<std::size_t>{2, 3, 3});
+  }
+
+  SECTION("single distance behaves like DistanceStopper") {
+    MultiDistanceStopper<Norm::L2> multi{{3.0}};
+    DistanceStopper<Norm::L2> single{3.0};
+    std::vector<Point2D> walk{{0, 0}, {2, 2}, {3, 0}};
+    REQUIRE(multi(walk) == single(walk));
+    walk.push_back({4, 0});
+    REQUIRE(multi(walk) == single(walk));
+  }
+
+  SECTION("rejects unsorted distances") {
+    REQUIRE_THROWS_AS(MultiDistanceStopper<Norm::L2>({2.0, 1.0}),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(MultiDistanceStopper<Norm::L2>({}),
+                      std::invalid_argument);
+  }
+}
+
+TEST_CASE("on_step agrees with the whole walk") {
+  const auto walk =
+      std::vector<Point2D>{{0, 0}, {1, 0}, {1, 2}, {0, 1}, {3, 1}, {5, 5}};
+
+  auto length = LengthStopper{3};
+  auto distance = DistanceStopper<Norm::L1>{3.5};
+  auto multi = MultiDistanceStopper<Norm::LINF>{{1.5, 2.5, 4.0}};
+  auto multi_whole = multi;
+
+  for (std::size_t i = 0; i < walk.size(); ++i) {
+    const auto prefix =
+        std::vector<Point2D>(walk.begin(), walk.begin() + i + 1);
+    REQUIRE(length.on_step(walk[i]) == length(prefix));
+    REQUIRE(distance.on_step(walk[i]) == distance(prefix));
+    REQUIRE(multi.on_step(walk[i]) == multi_whole(prefix));
+  }
+  REQUIRE(multi.lengths == multi_whole.lengths);
+  REQUIRE(multi.lengths == std::vector<std::size_t>{3, 5, 6});
+}
+
+TEST_CASE("Steps that certainly leave") {
+  SECTION("L1") {
+    const auto stopper = DistanceStopper<Norm::L1>{5.0};
+    const auto p = Point2D{1, -2};
+    // |p| = 3: a step of 8 may still land at norm 5 (inside)
+    REQUIRE_FALSE(stopper.leaves(p, 8.0));
+    REQUIRE(stopper.leaves(p, 9.0));
+    REQUIRE_FALSE(stopper.leaves(Point2D{0, 0}, 5.0));
+    REQUIRE(stopper.leaves(Point2D{0, 0}, 6.0));
+  }
+
+  SECTION("L2 leaves room for the rounding of the directions") {
+    const auto stopper = DistanceStopper<Norm::L2>{5.0};
+    REQUIRE_FALSE(stopper.leaves(Point2D{0, 0}, 6.0));
+    REQUIRE(stopper.leaves(Point2D{0, 0}, 6.5));
+    REQUIRE_FALSE(stopper.leaves(Point2D{3, 4}, 11.0));
+    REQUIRE(stopper.leaves(Point2D{3, 4}, 11.5));
+  }
+
+  SECTION("the exit point is outside") {
+    const auto single = DistanceStopper<Norm::L2>{4.5};
+    REQUIRE(single.on_step(single.exit_point<Point2D>()));
+    const auto multi = MultiDistanceStopper<Norm::LINF>{{1.0, 7.0}};
+    const auto x = multi.exit_point<Point3D>();
+    REQUIRE(norm<Norm::LINF>(x) > 7.0);
+    REQUIRE(norm<Norm::L1>(x) > 7.0);
+    REQUIRE(multi.leaves(Point3D{1, 1, 1}, 9.0));
+    REQUIRE_FALSE(multi.leaves(Point3D{1, 1, 1}, 8.0));
+  }
+}
@@ -0,0 +1,177 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "array_point.hpp"
+#include "hash_set.hpp"
+#include "point.hpp"
+#include "visited.hpp"
+
+using namespace lerw;
+
+TEST_CASE("HashVisited") {
+  auto visited = HashVisited<Point2D>{};
+  // also before the map has any slots
+  visited.prefetch(Point2D{1, 2});
+  REQUIRE(visited[Point2D{1, 2}] == HashVisited<Point2D>::npos);
+  visited.prefetch(Point2D{1, 2});
+  visited[Point2D{1, 2}] = 3;
+  REQUIRE(visited[Point2D{1, 2}] == 3);
+  visited.clear();
+  REQUIRE(visited[Point2D{1, 2}] == HashVisited<Point2D>::npos);
+}
+
+TEST_CASE("LatticeVisited") {
+  using npos_t = decltype(LatticeVisited<Point2D>::npos);
+  constexpr auto npos = npos_t{LatticeVisited<Point2D>::npos};
+  auto visited = LatticeVisited<Point2D>{2};
+  REQUIRE(visited.cells.size() == 25);
+
+  SECTION("inside and outside of the box") {
+    for (const auto p : {Point2D{0, 0}, Point2D{-2, 2}, Point2D{3, 0},
+                         Point2D{-100, 7}}) {
+      REQUIRE(visited[p] == npos);
+      visited[p] = 5;
+      REQUIRE(visited[p] == 5);
+    }
+    REQUIRE(visited.outside.size() == 2);
+    // points that map to the same row are still distinct
+    REQUIRE(visited[Point2D{2, -2}] == npos);
+  }
+
+  SECTION("clear") {
+    visited[Point2D{1, 1}] = 1;
+    visited[Point2D{5, 5}] = 2;
+    visited.clear();
+    REQUIRE(visited[Point2D{1, 1}] == npos);
+    REQUIRE(visited[Point2D{5, 5}] == npos);
+  }
+
+  SECTION("stamp wraps") {
+    visited[Point2D{1, 1}] = 1;
+    visited.stamp = UINT32_MAX;
+    visited[Point2D{0, 1}] = 1;
+    visited.clear();
+    REQUIRE(visited.stamp == 1);
+    REQUIRE(visited[Point2D{1, 1}] == npos);
+    REQUIRE(visited[Point2D{0, 1}] == npos);
+  }
+
+  SECTION("higher dimensions") {
+    auto visited4 = LatticeVisited<ArrayPoint<4>>{1};
+    REQUIRE(visited4.cells.size() == 81);
+    visited4[ArrayPoint<4>{{1, -1, 0, 1}}] = 7;
+    REQUIRE(visited4[ArrayPoint<4>{{1, -1, 0, 1}}] == 7);
+    REQUIRE(visited4[ArrayPoint<4>{{1, -1, 1, 0}}] ==
+            LatticeVisited<ArrayPoint<4>>::npos);
+  }
+
+  SECTION("too large") {
+    REQUIRE_FALSE(LatticeVisited<Point2D>::fits(1 << 16));
+    REQUIRE_THROWS_AS(LatticeVisited<Point2D>{1 << 16}, std::invalid_argument);
+  }
+}
+
+TEST_CASE("TileVisited") {
+  auto visited = TileVisited<Point2D>{};
+  const auto points = {Point2D{0, 0}, Point2D{15, 15}, Point2D{16, 0},
+                       Point2D{-1, -1}, Point2D{-17, 5}, Point2D{1 << 30, -3}};
+
+  for (const auto p : points) {
+    REQUIRE_FALSE(visited.contains(p));
+    REQUIRE(visited.insert(p));
+    REQUIRE(visited.contains(p));
+    REQUIRE_FALSE(visited.insert(p));
+  }
+  // (0, 0) and (15, 15) share a tile
+  REQUIRE(visited.tiles.size() == points.size() - 1);
+  REQUIRE_FALSE(visited.contains(Point2D{1, 0}));
+  REQUIRE_FALSE(visited.contains(Point2D{-16, 5}));
+
+  visited.erase(Point2D{-1, -1});
+  REQUIRE_FALSE(visited.contains(Point2D{-1, -1}));
+  REQUIRE(visited.contains(Point2D{-17, 5}));
+
+  visited.clear();
+  for (const auto p : points) {
+    REQUIRE_FALSE(visited.contains(p));
+  }
+
+  SECTION("other dimensions") {
+    auto visited1 = TileVisited<Point1D>{};
+    REQUIRE(visited1.insert(Point1D{-300}));
+    REQUIRE_FALSE(visited1.contains(Point1D{300}));
+    auto visited3 = TileVisited<Point3D>{};
+    REQUIRE(visited3.insert(Point3D{7, -8, 9}));
+    REQUIRE_FALSE(visited3.contains(Point3D{7, -8, 1}));
+    REQUIRE(visited3.contains(Point3D{7, -8, 9}));
+    auto visited5 = TileVisited<ArrayPoint<5>>{};
+    REQUIRE(visited5.insert(ArrayPoint<5>{{1, 2, 3, 4, -5}}));
+    REQUIRE(visited5.contains(ArrayPoint<5>{{1, 2, 3, 4, -5}}));
+    REQUIRE_FALSE(visited5.contains(ArrayPoint<5>{{1, 2, 3, 4, 5}}));
+  }
+}
+
+TEST_CASE("LifoHashSet") {
+  auto set = LifoHashSet<Point2D>{};
+  auto reference = std::unordered_set<Point2D>{};
+  auto stack = std::vector<Point2D>{};
+  auto rng = std::mt19937{};
+  auto coordinate = std::uniform_int_distribution<int_t>{-20, 20};
+
+  // mostly LIFO erasure, as for loop erasure, with some random erasures
+  for (int i = 0; i < 100000; ++i) {
+    const auto op = rng() % 4;
+    if (op < 2) {
+      const auto p = Point2D{coordinate(rng), coordinate(rng)};
+      REQUIRE(set.insert(p) == reference.insert(p).second);
+      stack.push_back(p);
+    } else if (op == 2 && not stack.empty()) {
+      set.erase(stack.back());
+      reference.erase(stack.back());
+      stack.pop_back();
+    } else {
+      const auto p = Point2D{coordinate(rng), coordinate(rng)};
+      set.erase(p);
+      reference.erase(p);
+    }
+    REQUIRE(set.size() == reference.size());
+  }
+  for (int_t x = -21; x <= 21; ++x) {
+    for (int_t y = -21; y <= 21; ++y) {
+      REQUIRE(set.contains(Point2D{x, y}) == reference.contains(Point2D{x, y}));
+    }
+  }
+
+  set.clear();
+  REQUIRE(set.empty());
+  REQUIRE_FALSE(set.contains(Point2D{0, 0}));
+  set.shrink();
+  REQUIRE(set.capacity() == 0);
+  REQUIRE(set.insert(Point2D{0, 0}));
+}
+
+TEST_CASE("choose_visited_backend") {
+  constexpr auto GB = std::size_t{1} << 30;
+  // small lattices that fit into cache
+  REQUIRE(choose_visited_backend<Point2D>(500, 8, 16 * GB) ==
+          VisitedBackend::lattice);
+  REQUIRE(choose_visited_backend<Point3D>(10, 8, 16 * GB) ==
+          VisitedBackend::lattice);
+  REQUIRE(choose_visited_backend<Point2D>(100, 8, 1 << 10) ==
+          VisitedBackend::tiles);
+  REQUIRE(choose_visited_backend<Point2D>(1000, 8, 16 * GB) ==
+          VisitedBackend::tiles);
+  REQUIRE(choose_visited_backend<Point3D>(1000, 8, 16 * GB) ==
+          VisitedBackend::tiles);
+  REQUIRE(choose_visited_backend<ArrayPoint<4>>(3, 1, 16 * GB) ==
+          VisitedBackend::hash);
+  // with the free memory of this machine, or the fixed budget
+  REQUIRE(choose_visited_backend<Point2D>(100, 8, available_memory()) ==
+          VisitedBackend::lattice);
+  REQUIRE(parse_visited_backend("tiles") == VisitedBackend::tiles);
+  REQUIRE(parse_visited_backend("lifo_set") == VisitedBackend::lifo_set);
+  REQUIRE_THROWS_AS(parse_visited_backend("tree"), std::invalid_argument);
+}